@@ -0,0 +1,355 @@
+#include "Batch.h"
+
+#include "kMST_ILP.h"
+#include "kMST_VNS.h"
+#include "LagrangianBound.h"
+#include "Portfolio.h"
+#include "kMST_BnB.h"
+
+#include <fstream>
+
+BatchRunner::BatchRunner() :
+		concurrency( 1 ), threadsPerJob( 1 ), timeLimit( -1 ), portfolioModels( Portfolio::parseModels( "scf,mtz,dcc" ) ),
+		cache( NULL ), next( 0 )
+{
+	pthread_mutex_init(&mutex, NULL);
+}
+
+BatchRunner::~BatchRunner()
+{
+	for (map<string, Instance*>::iterator iter = instances.begin(); iter != instances.end(); ++iter) {
+		delete iter->second;
+	}
+	delete cache;
+	pthread_mutex_destroy(&mutex);
+}
+
+void BatchRunner::readManifest( string manifest )
+{
+	ifstream ifs( manifest.c_str() );
+	if( ifs.fail() ) {
+		cerr << "could not open manifest " << manifest << "\n";
+		exit( -1 );
+	}
+
+	string line;
+	int lineNumber = 0;
+	while (getline(ifs, line)) {
+		lineNumber++;
+		line = line.substr(0, line.find('#'));
+
+		stringstream ss(line);
+		Job job;
+		if (!(ss >> job.file)) {
+			continue; // empty line
+		}
+		if (!(ss >> job.model >> job.k)) {
+			cerr << "invalid job in " << manifest << " line " << lineNumber << "\n";
+			exit( -1 );
+		}
+		// fail now rather than in the middle of the batch
+		if (job.model != "scf" && job.model != "mcf" && job.model != "mtz" && job.model != "dcc" &&
+				job.model != "gsec" && job.model != "vns" && job.model != "lagrange" && job.model != "portfolio" &&
+				job.model != "bnb" && job.model != "scf-root" && job.model != "mtz-root" && job.model != "mcf-lean") {
+			cerr << "unknown model " << job.model << " in " << manifest << " line " << lineNumber << "\n";
+			exit( -1 );
+		}
+		if (!(ss >> job.rounds) || job.rounds < 1) {
+			job.rounds = 1;
+		}
+		job.objectiveValue = 0;
+		job.nodes = 0;
+		job.wallTime = 0;
+		job.done = false;
+		job.cached = false;
+		job.solved = false;
+		job.optimal = false;
+		jobs.push_back(job);
+	}
+	ifs.close();
+}
+
+void BatchRunner::setConcurrency( u_int _concurrency )
+{
+	concurrency = max(_concurrency, 1u);
+}
+
+void BatchRunner::setThreadsPerJob( u_int _threadsPerJob )
+{
+	threadsPerJob = max(_threadsPerJob, 1u);
+}
+
+void BatchRunner::setTimeLimit( double seconds )
+{
+	timeLimit = seconds;
+}
+
+void BatchRunner::setPortfolioModels( const vector<string>& models )
+{
+	portfolioModels = models;
+}
+
+void BatchRunner::setBackend( string _backend )
+{
+	backend = _backend;
+}
+
+void BatchRunner::setCache( string directory )
+{
+	delete cache;
+	cache = new ResultCache( directory );
+}
+
+// heuristics and bounds are cheap and have no proof, so they are always run
+static bool isCached( const BatchRunner::Job& job )
+{
+	return job.model != "vns" && job.model != "lagrange";
+}
+
+const vector<BatchRunner::Job>& BatchRunner::getJobs() const
+{
+	return jobs;
+}
+
+BatchRunner::Job* BatchRunner::nextJob()
+{
+	Job* job = NULL;
+	pthread_mutex_lock(&mutex);
+	if (next < order.size()) {
+		job = &jobs[ order[next++] ];
+	}
+	pthread_mutex_unlock(&mutex);
+	return job;
+}
+
+void BatchRunner::runJob( Job& job )
+{
+	Instance& instance = *instances[job.file];
+	string cacheParams = backend.empty() ? "" : "backend=" + backend;
+
+	// feasible entries are MIP starts, optimal ones never get here
+	ResultCache::Entry cached;
+	bool hasCached = cache != NULL && isCached(job) &&
+			cache->lookup( hashes.find(job.file)->second, job.model, job.k, cacheParams, cached );
+	KTree tree;
+	bool optimal = false;
+
+	double start = Tools::wallTime();
+	// a solver error fails this job only, the others go on
+	try {
+		for (int round=0; round<job.rounds; round++) {
+			if (job.model == "vns") {
+				kMST_VNS vns( instance, job.k );
+				vns.setThreads( threadsPerJob );
+				vns.setTimeLimit( timeLimit >= 0 ? timeLimit : 10 );
+				vns.solve();
+				job.objectiveValue = vns.getObjectiveValue();
+				job.nodes = 0;
+			} else if (job.model == "lagrange") {
+				LagrangianBound bound( instance, job.k );
+				bound.setThreads( threadsPerJob );
+				bound.solve();
+				job.objectiveValue = bound.getUpperBound();
+				job.nodes = 0;
+			} else if (job.model == "bnb") {
+				kMST_BnB bnb( instance, job.k );
+				bnb.setThreads( threadsPerJob );
+				if (timeLimit >= 0) {
+					bnb.setTimeLimit( timeLimit );
+				}
+				bnb.solve();
+				job.objectiveValue = bnb.getObjectiveValue();
+				job.nodes = bnb.getNodes();
+				tree = bnb.getTree();
+				optimal = bnb.isOptimal();
+			} else if (job.model == "portfolio") {
+				Portfolio portfolio( instance, job.k, portfolioModels );
+				portfolio.setThreads( threadsPerJob );
+				if (timeLimit >= 0) {
+					portfolio.setTimeLimit( timeLimit );
+				}
+				portfolio.solve();
+				job.objectiveValue = portfolio.getObjectiveValue();
+				job.nodes = portfolio.getNodes();
+				tree = portfolio.getTree();
+				optimal = !portfolio.getWinner().empty();
+			} else {
+				kMST_ILP ilp( instance, job.model, job.k );
+				if (!backend.empty()) {
+					ilp.setBackend( backend );
+				}
+				ilp.setThreads( threadsPerJob );
+				if (hasCached) {
+					ilp.setWarmStart( cached.tree );
+				}
+				ilp.solve();
+				job.objectiveValue = ilp.getObjectiveValue();
+				job.nodes = ilp.getNodes();
+				tree = ilp.getTree();
+				optimal = ilp.isOptimal();
+			}
+		}
+	} catch (exception& e) {
+		job.error = e.what();
+	}
+	job.wallTime = (Tools::wallTime() - start) / job.rounds;
+	job.done = true;
+	// heuristics and bounds always have a tree
+	job.solved = job.model == "vns" || job.model == "lagrange" || tree.isValid();
+	job.optimal = optimal;
+
+	if (!job.error.empty()) {
+		cerr << "Failed " << job.file << " " << job.model << " k=" << job.k << ": " << job.error << "\n";
+		return;
+	}
+
+	if (cache != NULL && tree.isValid()) {
+		ResultCache::Entry entry;
+		entry.objectiveValue = job.objectiveValue;
+		entry.nodes = job.nodes;
+		entry.optimal = optimal;
+		entry.tree = tree;
+		cache->store( hashes.find(job.file)->second, job.model, job.k, cacheParams, entry );
+	}
+
+	cerr << "Finished " << job.file << " " << job.model << " k=" << job.k << ": ";
+	if (job.solved) {
+		cerr << job.objectiveValue;
+	} else {
+		cerr << "no solution";
+	}
+	cerr << " in " << job.wallTime << "s\n";
+}
+
+static void* runBatchWorker( void* arg )
+{
+	BatchRunner* runner = (BatchRunner*)arg;
+	BatchRunner::Job* job;
+	while ((job = runner->nextJob()) != NULL) {
+		runner->runJob(*job);
+	}
+	return NULL;
+}
+
+// larger instances first, so that the long jobs don't end up last
+struct LargerInstanceFirst
+{
+	const vector<BatchRunner::Job>* jobs;
+	const map<string, Instance*>* instances;
+
+	bool operator()( u_int a, u_int b ) const
+	{
+		const Instance* first = instances->find( (*jobs)[a].file )->second;
+		const Instance* second = instances->find( (*jobs)[b].file )->second;
+		if (first->n_edges != second->n_edges) {
+			return first->n_edges > second->n_edges;
+		}
+		return (*jobs)[a].k > (*jobs)[b].k;
+	}
+};
+
+void BatchRunner::run()
+{
+	// fail before the first job if a model can't run on the backend
+	for (unsigned int i=0; i<jobs.size(); i++) {
+		const string& model = jobs[i].model;
+		if (model != "vns" && model != "lagrange" && model != "bnb" && model != "portfolio" &&
+				!kMST_ILP::isSupported(model, backend)) {
+			cerr << "model " << model << " of job " << i + 1 << " needs the callbacks of CPLEX (make CPLEX=1, --backend cplex)\n";
+			exit( -1 );
+		}
+	}
+
+	// proven optimal results from the cache finish their jobs before any instance is read
+	for (unsigned int i=0; i<jobs.size() && cache != NULL; i++) {
+		Job& job = jobs[i];
+		if (hashes.find(job.file) == hashes.end()) {
+			hashes[job.file] = ResultCache::hashFile( job.file );
+		}
+		ResultCache::Entry cached;
+		if (isCached(job) && cache->lookup( hashes[job.file], job.model, job.k,
+				backend.empty() ? "" : "backend=" + backend, cached ) && cached.optimal) {
+			job.objectiveValue = cached.objectiveValue;
+			job.nodes = cached.nodes;
+			job.wallTime = 0;
+			job.done = true;
+			job.cached = true;
+			job.solved = true;
+			job.optimal = true;
+			cerr << "Cached " << job.file << " " << job.model << " k=" << job.k << ": " << job.objectiveValue << "\n";
+		}
+	}
+
+	// read every instance once, before any job starts
+	for (unsigned int i=0; i<jobs.size(); i++) {
+		if (!jobs[i].done && instances.find(jobs[i].file) == instances.end()) {
+			instances[jobs[i].file] = new Instance(jobs[i].file);
+		}
+	}
+
+	order.clear();
+	for (unsigned int i=0; i<jobs.size(); i++) {
+		if (!jobs[i].done) {
+			order.push_back(i);
+		}
+	}
+	LargerInstanceFirst compare = { &jobs, &instances };
+	stable_sort(order.begin(), order.end(), compare);
+	next = 0;
+
+	cerr << "Executing " << order.size() << " jobs, " << concurrency << " at a time with "
+			<< threadsPerJob << " threads each\r\n";
+
+	u_int workers = min(concurrency, max((u_int)order.size(), 1u));
+	vector<pthread_t> handles(workers);
+	for (u_int i=1; i<workers; i++) {
+		pthread_create(&handles[i], NULL, runBatchWorker, this);
+	}
+	runBatchWorker(this);
+	for (u_int i=1; i<workers; i++) {
+		pthread_join(handles[i], NULL);
+	}
+}
+
+static const string LOG_HEADER = "Filename\tModel\tNodes\tCost\tB&B N\tWallTime\tThreads\tStatus";
+
+void BatchRunner::writeLog( ostream& out, bool withHeader ) const
+{
+	if (withHeader) {
+		out << LOG_HEADER << "\r\n";
+	}
+	for (unsigned int i=0; i<jobs.size(); i++) {
+		const Job& job = jobs[i];
+		if (!job.done) {
+			continue;
+		}
+		out << job.file << "\t" << job.model << "\t" << job.k << "\t";
+		if (!job.error.empty()) {
+			out << "-\t-\t" << job.wallTime << "\t" << threadsPerJob << "\tfailed\r\n";
+		} else if (!job.solved) {
+			// hit a limit before any solution
+			out << "-\t" << job.nodes << "\t" << job.wallTime << "\t" << threadsPerJob << "\tunsolved\r\n";
+		} else if (isCached(job) && !job.optimal) {
+			// exact model stopped by a limit before the proof
+			out << job.objectiveValue << "\t" << job.nodes << "\t" << job.wallTime << "\t" << threadsPerJob << "\tlimit\r\n";
+		} else if (job.cached) {
+			// no time was spent on it
+			out << job.objectiveValue << "\t" << job.nodes << "\t-\t" << threadsPerJob << "\tcached\r\n";
+		} else {
+			out << job.objectiveValue << "\t" << job.nodes << "\t" << job.wallTime << "\t" << threadsPerJob << "\tok\r\n";
+		}
+	}
+}
+
+bool BatchRunner::isLogFile( string filename )
+{
+	ifstream in( filename.c_str() );
+	string header;
+	if (!getline(in, header)) {
+		return true;
+	}
+	if (!header.empty() && header[header.size() - 1] == '\r') {
+		header.erase(header.size() - 1);
+	}
+	return header == LOG_HEADER;
+}
@@ -0,0 +1,86 @@
+#ifndef __BATCH__H__
+#define __BATCH__H__
+
+#include "Tools.h"
+#include "Instance.h"
+#include "ResultCache.h"
+
+#include <map>
+#include <pthread.h>
+
+using namespace std;
+
+// runs a manifest of experiments in one process
+//
+// manifest lines: <instance file> <model> <k> [<rounds>], '#' starts a comment
+// every instance is read once and shared read-only, jobs run on a pool of
+// concurrent workers which each get a fixed thread budget
+class BatchRunner
+{
+
+public:
+
+	struct Job
+	{
+		string file, model;
+		int k, rounds;
+
+		// results of the last round, the wall time is averaged over the rounds
+		double objectiveValue;
+		int nodes;
+		double wallTime;
+		bool done;
+		bool cached; // proven optimal in the cache, not run
+		bool solved; // false if an exact model ended without a solution, objectiveValue is 0 then
+		bool optimal; // proven, always false for vns and lagrange
+		string error; // of a failed job, empty otherwise
+	};
+
+	BatchRunner();
+	~BatchRunner();
+
+	void readManifest( string manifest );
+
+	void setConcurrency( u_int _concurrency );
+	void setThreadsPerJob( u_int _threadsPerJob );
+	void setTimeLimit( double seconds ); // of vns (default 10), bnb and portfolio jobs (default none), < 0: default
+	void setPortfolioModels( const vector<string>& models ); // raced by portfolio jobs, default scf,mtz,dcc
+	// MILPBackend of the model jobs, empty: MILPBackend::defaultName()
+	void setBackend( string _backend );
+	// ResultCache in directory for the exact models, jobs with a proven optimal entry aren't run
+	void setCache( string directory );
+
+	void run();
+
+	// one line per finished job in manifest order: the columns of the single run log, but wall time
+	// instead of CPU time, then threads per job and status (ok, limit for unproven results of
+	// exact models, cached, unsolved or failed), so it needs a file of its own
+	void writeLog( ostream& out, bool withHeader ) const;
+	static bool isLogFile( string filename ); // missing, empty or written by writeLog
+
+	const vector<Job>& getJobs() const;
+
+	// used by the workers
+	void runJob( Job& job );
+	Job* nextJob();
+
+private:
+
+	vector<Job> jobs;
+	map<string, Instance*> instances;
+
+	u_int concurrency, threadsPerJob;
+	double timeLimit;
+	vector<string> portfolioModels;
+	string backend;
+	ResultCache* cache; // NULL if not set
+	map<string, string> hashes; // file contents of the instances, for the cache
+
+	vector<u_int> order; // jobs in scheduling order
+	u_int next;
+	pthread_mutex_t mutex;
+
+};
+// BatchRunner
+
+#endif //__BATCH__H__
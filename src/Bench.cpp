@@ -0,0 +1,347 @@
+#ifndef __BENCH__CPP__
+#define __BENCH__CPP__
+
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <unistd.h>
+#include "Tools.h"
+#include "Instance.h"
+#include "kMST_ILP.h"
+#include "kMST_VNS.h"
+#include "LagrangianBound.h"
+#include "Batch.h"
+#include "Portfolio.h"
+#include "kMST_BnB.h"
+
+using namespace std;
+
+// phases of one run in wall clock seconds, cpu is process user time
+enum Phase { PARSE, BUILD, EXTRACTION, ROOT_LP, BRANCH_AND_BOUND, TOTAL, CPU, N_PHASES };
+static const char* PHASE_NAMES[N_PHASES] = { "parse", "build", "extraction", "rootLP", "branchAndBound", "total", "cpu" };
+
+struct BenchResult
+{
+	BatchRunner::Job job;
+	u_int threads;
+	double objectiveValue;
+	int nodes;
+	vector<double> samples[N_PHASES];
+	double median[N_PHASES], p95[N_PHASES];
+	vector<double> memory; // peak resident set size per run in MB
+	int optimalRuns; // runs which proved optimality, always 0 for vns and lagrange
+	double speedup; // median total time of the first thread count divided by this one's
+
+	// baseline from a log file, time < 0 if there is none
+	double baselineCost, baselineTime;
+	bool regression;
+};
+
+void usage()
+{
+	cout << "USAGE:\t<program> -b manifest [-n <repetitions> -c <threads> -t <seconds> -o <csv file> -J <json file>\n";
+	cout << "\t\t-B <baseline log> -s <slowdown factor> -a <absolute slack in seconds>\n";
+	cout << "\t\t-S <thread counts, e.g. 1,2,4,8> -P deterministic|opportunistic|auto -T <seconds>\n";
+	cout << "\t\t-F <portfolio models>]\n";
+	cout << "\truns every job of the manifest n times and reports median and p95 of the phases\n";
+	cout << "\tparse, build, extraction, root LP, branch-and-bound, total (wall clock) and cpu time,\n";
+	cout << "\tthe median peak memory and how many runs proved optimality\n";
+	cout << "\t-t limits vns runs (default 10s), -T bnb, the CPLEX models and portfolio (default none),\n";
+	cout << "\t-F the models raced by portfolio jobs (default scf,mtz,dcc)\n";
+	cout << "\t-B compares cpu time and cost to a log written by kmst -l, a job regresses if\n";
+	cout << "\tits cost differs or its median cpu time exceeds baseline * factor + slack, the times of\n";
+	cout << "\tlog.txt are single core runs on the ADS server, so scale them with -s on other machines\n";
+	cout << "\t-S runs every job with each thread count and reports the speedup over the first one,\n";
+	cout << "\tonly the runs with the first thread count are compared to the baseline\n";
+	cout << "EXAMPLE:\t" << "./kmst-bench -b bench.jobs -n 5 -B log.txt -o bench.csv\n";
+	cout << "\t\t" << "./kmst-bench -b scaling.jobs -n 3 -S 1,2,4,8,16,32 -o scaling.csv\n";
+	cout << "\t\t" << "./kmst-bench -b sizes.jobs -n 1 -t 60 -T 60 -o sizes.csv\n\n";
+	exit( 1 );
+} // usage
+
+// nearest rank percentile
+static double percentile( vector<double> values, double p )
+{
+	if (values.empty()) {
+		return 0;
+	}
+	sort(values.begin(), values.end());
+	unsigned int rank = (unsigned int)ceil(p * values.size());
+	return values[ max(rank, 1u) - 1 ];
+}
+
+static void runOnce( BenchResult& result, int parallelMode, double timeLimit, double exactTimeLimit,
+		const vector<string>& portfolioModels )
+{
+	const BatchRunner::Job& job = result.job;
+	u_int threads = result.threads;
+	double times[N_PHASES];
+	for (int p=0; p<N_PHASES; p++) {
+		times[p] = 0;
+	}
+
+	bool optimal = false;
+	Tools::resetPeakMemory();
+	double cpuStart = Tools::CPUtime();
+	double start = Tools::wallTime();
+	Instance instance( job.file );
+	times[PARSE] = Tools::wallTime() - start;
+
+	if (job.model == "vns") {
+		kMST_VNS vns( instance, job.k );
+		vns.setThreads( threads );
+		vns.setTimeLimit( timeLimit );
+		vns.solve();
+		result.objectiveValue = vns.getObjectiveValue();
+		result.nodes = 0;
+	} else if (job.model == "lagrange") {
+		LagrangianBound bound( instance, job.k );
+		bound.setThreads( threads );
+		bound.solve();
+		result.objectiveValue = bound.getUpperBound();
+		result.nodes = 0;
+	} else if (job.model == "bnb") {
+		kMST_BnB bnb( instance, job.k );
+		bnb.setThreads( threads );
+		if (exactTimeLimit > 0) {
+			bnb.setTimeLimit( exactTimeLimit );
+		}
+		bnb.solve();
+		result.objectiveValue = bnb.getObjectiveValue();
+		result.nodes = bnb.getNodes();
+		optimal = bnb.isOptimal();
+	} else if (job.model == "portfolio") {
+		Portfolio portfolio( instance, job.k, portfolioModels );
+		portfolio.setThreads( threads );
+		portfolio.setTimeLimit( exactTimeLimit );
+		portfolio.solve();
+		result.objectiveValue = portfolio.getObjectiveValue();
+		result.nodes = portfolio.getNodes();
+		optimal = !portfolio.getWinner().empty();
+	} else {
+		kMST_ILP ilp( instance, job.model, job.k );
+		ilp.setThreads( threads );
+		ilp.setParallelMode( parallelMode );
+		ilp.setTimeLimit( exactTimeLimit );
+		ilp.solve();
+		result.objectiveValue = ilp.getObjectiveValue();
+		result.nodes = ilp.getNodes();
+		optimal = ilp.isOptimal();
+
+		const kMST_ILP::Timings& timings = ilp.getTimings();
+		times[BUILD] = timings.build;
+		times[EXTRACTION] = timings.extraction;
+		times[ROOT_LP] = timings.rootLP;
+		times[BRANCH_AND_BOUND] = timings.branchAndBound;
+	}
+
+	times[TOTAL] = Tools::wallTime() - start;
+	times[CPU] = Tools::CPUtime() - cpuStart;
+	for (int p=0; p<N_PHASES; p++) {
+		result.samples[p].push_back(times[p]);
+	}
+	result.memory.push_back(Tools::peakMemory());
+	if (optimal) {
+		result.optimalRuns++;
+	}
+}
+
+// last entry per file, model and k of a log written by kmst -l, the cpu times of log.txt
+// come from single core runs on the ADS server (see report/report.tex), not from this machine
+static void readBaseline( string file, map<string, pair<double, double> >& baseline )
+{
+	ifstream ifs( file.c_str() );
+	if( ifs.fail() ) {
+		cerr << "could not open baseline " << file << "\n";
+		exit( -1 );
+	}
+
+	// batch and sweep results have wall times
+	string line;
+	getline(ifs, line);
+	if (line.find("\tCPUTime") == string::npos) {
+		cerr << "baseline " << file << " has no CPUTime column, it needs a log of single runs\n";
+		exit( -1 );
+	}
+	while (getline(ifs, line)) {
+		stringstream ss(line);
+		string name, model, rest;
+		int k, nodes;
+		double cost, time;
+		// rows without results ("-") or with a note behind them (other versions) are no baseline
+		if (ss >> name >> model >> k >> cost >> nodes >> time && !(ss >> rest)) {
+			stringstream key;
+			key << name << "\t" << model << "\t" << k;
+			baseline[key.str()] = pair<double, double>(cost, time);
+		}
+	}
+	ifs.close();
+}
+
+static void writeCSV( ostream& out, const vector<BenchResult>& results )
+{
+	out << "file,model,k,threads,runs,cost,nodes";
+	for (int p=0; p<N_PHASES; p++) {
+		out << "," << PHASE_NAMES[p] << "_median," << PHASE_NAMES[p] << "_p95";
+	}
+	out << ",memory_median,optimal_runs,speedup,baseline_cost,baseline_cpu,regression\n";
+
+	for (unsigned int i=0; i<results.size(); i++) {
+		const BenchResult& r = results[i];
+		out << r.job.file << "," << r.job.model << "," << r.job.k << "," << r.threads << ","
+				<< r.samples[TOTAL].size() << "," << r.objectiveValue << "," << r.nodes;
+		for (int p=0; p<N_PHASES; p++) {
+			out << "," << r.median[p] << "," << r.p95[p];
+		}
+		out << "," << percentile(r.memory, 0.5) << "," << r.optimalRuns << "," << r.speedup;
+		if (r.baselineTime >= 0) {
+			out << "," << r.baselineCost << "," << r.baselineTime;
+		} else {
+			out << ",,";
+		}
+		out << "," << (r.regression ? 1 : 0) << "\n";
+	}
+}
+
+static void writeJSON( ostream& out, const vector<BenchResult>& results )
+{
+	out << "[\n";
+	for (unsigned int i=0; i<results.size(); i++) {
+		const BenchResult& r = results[i];
+		out << "  {\"file\": \"" << r.job.file << "\", \"model\": \"" << r.job.model << "\", \"k\": " << r.job.k
+				<< ", \"threads\": " << r.threads << ", \"runs\": " << r.samples[TOTAL].size() << ", \"cost\": " << r.objectiveValue
+				<< ", \"nodes\": " << r.nodes << ",\n   \"phases\": {";
+		for (int p=0; p<N_PHASES; p++) {
+			out << (p > 0 ? ", " : "") << "\"" << PHASE_NAMES[p] << "\": {\"median\": " << r.median[p]
+					<< ", \"p95\": " << r.p95[p] << "}";
+		}
+		out << "},\n   \"memory\": " << percentile(r.memory, 0.5) << ", \"optimalRuns\": " << r.optimalRuns
+				<< ", \"speedup\": " << r.speedup << ", ";
+		if (r.baselineTime >= 0) {
+			out << "\"baseline\": {\"cost\": " << r.baselineCost << ", \"cpu\": " << r.baselineTime << "}, ";
+		}
+		out << "\"regression\": " << (r.regression ? "true" : "false") << "}"
+				<< (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "]\n";
+}
+
+int main( int argc, char *argv[] )
+{
+	int opt;
+	string manifest(""), csvFile(""), jsonFile(""), baselineFile("");
+	int repetitions = 5;
+	vector<u_int> threadCounts(1, 1);
+	int parallelMode = MILPBackend::DETERMINISTIC;
+	double timeLimit = 10, exactTimeLimit = 0;
+	vector<string> portfolioModels = Portfolio::parseModels( "scf,mtz,dcc" );
+	double slowdown = 1.25, slack = 0.05;
+	while( (opt = getopt( argc, argv, "b:n:c:t:o:J:B:s:a:S:P:T:F:" )) != EOF) {
+		switch( opt ) {
+			case 'b': manifest = optarg; break;
+			case 'n': repetitions = max(atoi( optarg ), 1); break;
+			case 'c': threadCounts.assign(1, max(atoi( optarg ), 1)); break;
+			case 't': timeLimit = atof( optarg ); break;
+			case 'o': csvFile = optarg; break;
+			case 'J': jsonFile = optarg; break;
+			case 'B': baselineFile = optarg; break;
+			case 's': slowdown = atof( optarg ); break;
+			case 'a': slack = atof( optarg ); break;
+			case 'S': {
+				threadCounts.clear();
+				stringstream ss(optarg);
+				string count;
+				while (getline(ss, count, ',')) {
+					threadCounts.push_back(max(atoi( count.c_str() ), 1));
+				}
+				if (threadCounts.empty()) {
+					usage();
+				}
+				break;
+			}
+			case 'P': parallelMode = kMST_ILP::parseParallelMode( optarg ); break;
+			case 'T': exactTimeLimit = atof( optarg ); break;
+			case 'F': portfolioModels = Portfolio::parseModels( optarg ); break;
+			default: usage(); break;
+		}
+	}
+	if (manifest.empty()) {
+		usage();
+	}
+
+	BatchRunner batch;
+	batch.readManifest( manifest );
+
+	map<string, pair<double, double> > baseline;
+	if (!baselineFile.empty()) {
+		readBaseline( baselineFile, baseline );
+	}
+
+	// jobs one after another, so they don't disturb each others timings
+	// one result per job and thread count
+	vector<BenchResult> results(batch.getJobs().size() * threadCounts.size());
+	int regressions = 0;
+	for (unsigned int i=0; i<results.size(); i++) {
+		BenchResult& r = results[i];
+		r.job = batch.getJobs()[i / threadCounts.size()];
+		r.threads = threadCounts[i % threadCounts.size()];
+		r.optimalRuns = 0;
+		// timings of a failed job mean nothing, so the solver error ends the benchmark
+		try {
+			for (int run=0; run<repetitions; run++) {
+				runOnce( r, parallelMode, timeLimit, exactTimeLimit, portfolioModels );
+			}
+		} catch (exception& e) {
+			cerr << r.job.file << " " << r.job.model << " k=" << r.job.k << ": " << e.what() << "\n";
+			exit( -1 );
+		}
+		for (int p=0; p<N_PHASES; p++) {
+			r.median[p] = percentile(r.samples[p], 0.5);
+			r.p95[p] = percentile(r.samples[p], 0.95);
+		}
+		const BenchResult& reference = results[i - i % threadCounts.size()];
+		r.speedup = r.median[TOTAL] > 0 ? reference.median[TOTAL] / r.median[TOTAL] : 1;
+
+		stringstream key;
+		key << r.job.file << "\t" << r.job.model << "\t" << r.job.k;
+		map<string, pair<double, double> >::const_iterator base = baseline.find(key.str());
+		r.baselineCost = 0;
+		r.baselineTime = -1;
+		r.regression = false;
+		if (base != baseline.end() && i % threadCounts.size() == 0) {
+			r.baselineCost = base->second.first;
+			r.baselineTime = base->second.second;
+			// only exact models have to reproduce the cost
+			bool exact = (r.job.model != "vns" && r.job.model != "lagrange");
+			r.regression = (exact && fabs(r.objectiveValue - r.baselineCost) > 1e-6) ||
+					r.median[CPU] > r.baselineTime * slowdown + slack;
+		}
+		if (r.regression) {
+			regressions++;
+		}
+
+		cerr << r.job.file << " " << r.job.model << " k=" << r.job.k << " threads=" << r.threads
+				<< ": total " << r.median[TOTAL] << "s (p95 " << r.p95[TOTAL] << "s), cpu " << r.median[CPU]
+				<< "s, memory " << percentile(r.memory, 0.5) << "MB, speedup " << r.speedup;
+		if (r.baselineTime >= 0) {
+			cerr << ", baseline " << r.baselineTime << "s" << (r.regression ? " REGRESSION" : "");
+		}
+		cerr << "\n";
+	}
+
+	if (!csvFile.empty()) {
+		ofstream out(csvFile.c_str());
+		writeCSV(out, results);
+	} else {
+		writeCSV(cout, results);
+	}
+	if (!jsonFile.empty()) {
+		ofstream out(jsonFile.c_str());
+		writeJSON(out, results);
+	}
+
+	cerr << regressions << " of " << results.size() << " jobs regressed\n";
+	return regressions > 0 ? 1 : 0;
+} // main
+
+#endif // __BENCH__CPP__
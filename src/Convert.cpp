@@ -0,0 +1,34 @@
+#ifndef __CONVERT__CPP__
+#define __CONVERT__CPP__
+
+#include <iostream>
+#include <cstdlib>
+#include "Instance.h"
+
+using namespace std;
+
+void usage()
+{
+	cout << "USAGE:\t<program> filename [filename ...]\n";
+	cout << "\twrites the binary instance format to <filename>.kmst\n";
+	cout << "EXAMPLE:\t" << "./kmst-convert data/*.dat\n\n";
+	exit( 1 );
+} // usage
+
+int main( int argc, char *argv[] )
+{
+	if (argc < 2) {
+		usage();
+	}
+
+	for (int i=1; i<argc; i++) {
+		string file( argv[i] );
+		Instance instance( file );
+		instance.writeBinary( file + ".kmst" );
+		cout << "Written " << file << ".kmst\n";
+	}
+
+	return 0;
+} // main
+
+#endif // __CONVERT__CPP__
@@ -0,0 +1,573 @@
+#include "CplexBackend.h"
+
+#ifdef KMST_CPLEX
+
+#include <set>
+
+static IloNum toCplex( double bound )
+{
+	return bound >= MILPBackend::INF ? IloInfinity : (bound <= -MILPBackend::INF ? -IloInfinity : bound);
+}
+
+static vector<double> toVector( const IloNumArray& values )
+{
+	vector<double> result(values.getSize());
+	for (IloInt i=0; i<values.getSize(); i++) {
+		result[i] = values[i];
+	}
+	return result;
+}
+
+// cuts generated by CPLEX itself, the rows of the callbacks are not counted
+static const IloCplex::CutType CUT_TYPES[] = {
+	IloCplex::CutCover, IloCplex::CutGubCover, IloCplex::CutFlowCover, IloCplex::CutClique,
+	IloCplex::CutFrac, IloCplex::CutMir, IloCplex::CutFlowPath, IloCplex::CutDisj,
+	IloCplex::CutImplBd, IloCplex::CutZeroHalf, IloCplex::CutMCF
+};
+
+// ----- callbacks -----------------------------------------------------
+
+// node of a heuristic or branch callback, values and bounds are read in main
+// since the query functions of the CPLEX callbacks are protected
+class CplexNode : public MILPBackend::BranchNode
+{
+
+public:
+
+	int nodes;
+	bool feasible;
+	double incumbent;
+	vector<double> values, upperBounds;
+
+	vector<int> fixed;
+	int branchColumn;
+
+	CplexNode() : nodes( 0 ), feasible( false ), incumbent( 0 ), branchColumn( -1 ) {}
+
+	int getNodes() const { return nodes; }
+	bool hasIncumbent() const { return feasible; }
+	double getIncumbent() const { return incumbent; }
+	double getValue( int column ) const { return values[column]; }
+	double getUpperBound( int column ) const { return upperBounds[column]; }
+
+	void fixToZero( int column ) { fixed.push_back(column); }
+	void branchOn( int column ) { branchColumn = column; }
+
+};
+
+// integer solutions: rows violated by them are added for good
+ILOLAZYCONSTRAINTCALLBACK1(LazyDispatch, CplexBackend*, backend)
+{
+	IloNumArray values(getEnv());
+	getValues(values, backend->getColumns());
+
+	vector<MILPBackend::Row> rows;
+	backend->getCallback()->separateLazy(toVector(values), rows);
+	for (unsigned int i=0; i<rows.size(); i++) {
+		add(backend->toRange(rows[i])).end();
+	}
+	values.end();
+}
+
+// fractional solutions: cuts may be purged by CPLEX later on
+ILOUSERCUTCALLBACK1(UserCutDispatch, CplexBackend*, backend)
+{
+	IloNumArray values(getEnv());
+	getValues(values, backend->getColumns());
+
+	vector<MILPBackend::Row> rows;
+	backend->getCallback()->separateCuts(toVector(values), rows);
+	for (unsigned int i=0; i<rows.size(); i++) {
+		add(backend->toRange(rows[i]), IloCplex::UseCutPurge).end();
+	}
+	values.end();
+}
+
+ILOHEURISTICCALLBACK1(HeuristicDispatch, CplexBackend*, backend)
+{
+	IloEnv env = getEnv();
+	const IloNumVarArray& columns = backend->getColumns();
+
+	CplexNode node;
+	node.nodes = getNnodes();
+	node.feasible = hasIncumbent();
+	node.incumbent = node.feasible ? getIncumbentObjValue() : 0;
+	{
+		IloNumArray values(env), upperBounds(env);
+		getValues(values, columns);
+		getUBs(upperBounds, columns);
+		node.values = toVector(values);
+		node.upperBounds = toVector(upperBounds);
+		values.end();
+		upperBounds.end();
+	}
+
+	MILPBackend::Expr solution;
+	double objective = 0;
+	if (!backend->getCallback()->findSolution(node, solution, objective) || solution.columns.empty()) {
+		return;
+	}
+
+	IloNumVarArray vars(env);
+	IloNumArray values(env);
+	for (unsigned int i=0; i<solution.columns.size(); i++) {
+		vars.add(columns[ solution.columns[i] ]);
+		values.add(solution.values[i]);
+	}
+	setSolution(vars, values, objective);
+	vars.end();
+	values.end();
+}
+
+// the fixings of the callback are added to every child, children which raise a fixed column are left out
+ILOBRANCHCALLBACK1(BranchDispatch, CplexBackend*, backend)
+{
+	// nothing to branch on at integer feasible nodes
+	if (getBranchType() != BranchOnVariable || getNbranches() == 0) {
+		return;
+	}
+	IloEnv env = getEnv();
+	const IloNumVarArray& columns = backend->getColumns();
+
+	CplexNode node;
+	node.nodes = getNnodes();
+	node.feasible = hasIncumbent();
+	node.incumbent = node.feasible ? getIncumbentObjValue() : 0;
+	{
+		IloNumArray values(env), upperBounds(env);
+		getValues(values, columns);
+		getUBs(upperBounds, columns);
+		node.values = toVector(values);
+		node.upperBounds = toVector(upperBounds);
+		values.end();
+		upperBounds.end();
+	}
+
+	backend->getCallback()->branch(node);
+	if (node.branchColumn < 0 && node.fixed.empty()) {
+		return; // CPLEX branches as usual
+	}
+
+	set<void*> fixed;
+	for (unsigned int i=0; i<node.fixed.size(); i++) {
+		fixed.insert(columns[ node.fixed[i] ].getImpl());
+	}
+
+	IloNumVarArray vars(env);
+	IloNumArray bounds(env);
+	IloCplex::BranchDirectionArray dirs(env);
+	IloInt branches = (node.branchColumn >= 0) ? 2 : getNbranches();
+	int made = 0, dropped = 0;
+	for (IloInt i=0; i<branches; i++) {
+		vars.clear();
+		bounds.clear();
+		dirs.clear();
+		IloNum estimate;
+		if (node.branchColumn >= 0) {
+			vars.add(columns[ node.branchColumn ]);
+			bounds.add(i == 0 ? 0 : 1);
+			dirs.add(i == 0 ? IloCplex::BranchDown : IloCplex::BranchUp);
+			estimate = getObjValue();
+		} else {
+			estimate = getBranch(vars, bounds, dirs, i);
+		}
+
+		bool useless = false;
+		for (IloInt j=0; j<vars.getSize(); j++) {
+			useless = useless || (dirs[j] != IloCplex::BranchDown && bounds[j] > 0.5 &&
+					fixed.count(vars[j].getImpl()) > 0);
+		}
+		if (useless) {
+			dropped++;
+			continue;
+		}
+
+		for (unsigned int j=0; j<node.fixed.size(); j++) {
+			vars.add(columns[ node.fixed[j] ]);
+			bounds.add(0);
+			dirs.add(IloCplex::BranchDown);
+		}
+		makeBranch(vars, bounds, dirs, estimate);
+		made++;
+	}
+	// every child raised a fixed column
+	if (made == 0 && dropped > 0) {
+		prune();
+	}
+
+	vars.end();
+	bounds.end();
+	dirs.end();
+}
+
+// progress of the search and improved incumbents
+ILOMIPINFOCALLBACK1(InfoDispatch, CplexBackend*, backend)
+{
+	if (backend->hasHook(MILPBackend::PROGRESS)) {
+		MILPBackend::Progress state;
+		state.nodes = getNnodes();
+		state.feasible = hasIncumbent();
+		state.incumbent = state.feasible ? getIncumbentObjValue() : 0;
+		state.bound = getBestObjValue();
+		state.cuts = 0;
+		for (unsigned int i=0; i<sizeof(CUT_TYPES) / sizeof(CUT_TYPES[0]); i++) {
+			state.cuts += getNcuts(CUT_TYPES[i]);
+		}
+		backend->getCallback()->progress(state);
+	}
+
+	if (backend->hasHook(MILPBackend::INCUMBENT) && hasIncumbent() &&
+			backend->isNewIncumbent(getIncumbentObjValue())) {
+		IloNumArray values(getEnv());
+		getIncumbentValues(values, backend->getColumns());
+		backend->getCallback()->incumbent(toVector(values), getIncumbentObjValue());
+		values.end();
+	}
+}
+
+// ----- backend -------------------------------------------------------
+
+CplexBackend::CplexBackend() :
+		matrixFirstRow( -1 ), matrixColumns( 0 ), callback( NULL ), hooks( 0 ), threads( 0 ), timeLimit( 0 ),
+		parallelMode( DETERMINISTIC ), workMemory( 0 ), treeMemory( 0 ), logging( false ),
+		extracted( false ), solved( false ), feasible( false ), optimal( false ), reportedIncumbent( INF )
+{
+	pthread_mutex_init(&incumbentMutex, NULL);
+	env = IloEnv();
+	model = IloModel( env );
+	columns = IloNumVarArray( env );
+	rows = IloRangeArray( env );
+	objective = IloExpr( env );
+	aborter = IloCplex::Aborter( env );
+}
+
+CplexBackend::~CplexBackend()
+{
+	// free global CPLEX resources
+	objective.end();
+	if (extracted) {
+		cplex.end();
+	}
+	model.end();
+	env.end();
+	pthread_mutex_destroy(&incumbentMutex);
+}
+
+int CplexBackend::addColumn( double lb, double ub, double cost, VarType type, string name )
+{
+	IloNumVar::Type cplexType = (type == CONTINUOUS ? IloNumVar::Float : (type == BINARY ? IloNumVar::Bool : IloNumVar::Int));
+	IloNumVar var( env, toCplex(lb), toCplex(ub), cplexType, name.empty() ? 0 : name.c_str() );
+	columns.add(var);
+	if (cost != 0) {
+		objective += cost * var;
+	}
+	return columns.getSize() - 1;
+}
+
+void CplexBackend::setBounds( int column, double lb, double ub )
+{
+	columns[column].setBounds(toCplex(lb), toCplex(ub));
+}
+
+int CplexBackend::addRow( const Expr& expr, double lb, double ub )
+{
+	Row row = { expr, lb, ub };
+	IloRange range = toRange(row);
+	model.add(range);
+	rows.add(range);
+	return rows.getSize() - 1;
+}
+
+// the block goes into the LP matrix of the model as it is (column indices of the matrix are those of
+// the backend), so no expression is built per row
+int CplexBackend::addRows( const RowBlock& block )
+{
+	int first = rows.getSize();
+	IloInt count = block.lb.size();
+	if (count == 0) {
+		return first;
+	}
+
+	if (matrixFirstRow < 0) {
+		matrix = IloLPMatrix( env );
+		model.add( matrix );
+		matrixFirstRow = first;
+	}
+	if (matrixColumns < columns.getSize()) {
+		IloNumVarArray added(env);
+		for (IloInt i=matrixColumns; i<columns.getSize(); i++) {
+			added.add(columns[i]);
+		}
+		matrix.addCols(added);
+		matrixColumns = columns.getSize();
+		added.end();
+	}
+
+	IloNumArray lb(env, count), ub(env, count);
+	for (IloInt row=0; row<count; row++) {
+		lb[row] = toCplex(block.lb[row]);
+		ub[row] = toCplex(block.ub[row]);
+	}
+	IloRangeArray ranges(env, lb, ub);
+	vector<IloInt> begin(block.begin.begin(), block.begin.end());
+	vector<IloInt> indices(block.columns.begin(), block.columns.end());
+	matrix.addRows(ranges, indices.size(), &begin[0], indices.empty() ? NULL : &indices[0],
+			block.values.empty() ? NULL : &block.values[0]);
+	rows.add(ranges);
+	lb.end();
+	ub.end();
+	return first;
+}
+
+void CplexBackend::setRowBounds( int row, double lb, double ub )
+{
+	rows[row].setBounds(toCplex(lb), toCplex(ub));
+}
+
+// rows of the matrix are changed through it only
+void CplexBackend::setCoefficient( int row, int column, double value )
+{
+	if (matrixFirstRow >= 0 && row >= matrixFirstRow && column < matrixColumns) {
+		matrix.setNZ(row - matrixFirstRow, column, value);
+	} else {
+		rows[row].setLinearCoef(columns[column], value);
+	}
+}
+
+void CplexBackend::setThreads( u_int _threads )
+{
+	threads = _threads;
+}
+
+void CplexBackend::setTimeLimit( double seconds )
+{
+	timeLimit = seconds;
+}
+
+void CplexBackend::setParallelMode( int mode )
+{
+	parallelMode = mode;
+}
+
+void CplexBackend::setMemoryLimits( double _workMemory, double _treeMemory )
+{
+	workMemory = _workMemory;
+	treeMemory = _treeMemory;
+}
+
+void CplexBackend::setLogging( bool _logging )
+{
+	logging = _logging;
+}
+
+void CplexBackend::setCallback( Callback* _callback, int _hooks )
+{
+	callback = _callback;
+	hooks = _hooks;
+}
+
+int CplexBackend::getSupportedHooks() const
+{
+	return supportedHooks("cplex");
+}
+
+void CplexBackend::addMIPStart( const Expr& start )
+{
+	extract();
+	IloNumVarArray startVars(env);
+	IloNumArray startValues(env);
+	for (unsigned int i=0; i<start.columns.size(); i++) {
+		startVars.add(columns[ start.columns[i] ]);
+		startValues.add(start.values[i]);
+	}
+	cplex.addMIPStart(startVars, startValues, IloCplex::MIPStartAuto, "heuristic");
+	startVars.end();
+	startValues.end();
+}
+
+void CplexBackend::clearMIPStarts()
+{
+	if (extracted && cplex.getNMIPStarts() > 0) {
+		cplex.deleteMIPStarts(0, cplex.getNMIPStarts());
+	}
+}
+
+void CplexBackend::abort()
+{
+	aborter.abort();
+}
+
+void CplexBackend::extract()
+{
+	if (extracted) {
+		return;
+	}
+	try {
+		// columns without a row still have to be part of the model
+		model.add(columns);
+		model.add(IloMinimize(env, objective));
+		cplex = IloCplex( model );
+		// export model to a text file
+		//cplex.exportModel( "model.lp" );
+
+		if (callback != NULL) {
+			if (hooks & LAZY) {
+				cplex.use(LazyDispatch(env, this));
+			}
+			if (hooks & USER_CUTS) {
+				cplex.use(UserCutDispatch(env, this));
+			}
+			if (hooks & HEURISTIC) {
+				cplex.use(HeuristicDispatch(env, this));
+			}
+			if (hooks & BRANCH) {
+				cplex.use(BranchDispatch(env, this));
+			}
+			if (hooks & (PROGRESS | INCUMBENT)) {
+				cplex.use(InfoDispatch(env, this));
+			}
+		}
+		cplex.use(aborter);
+		extracted = true;
+	} catch (IloAlgorithm::CannotExtractException& e) {
+		stringstream message;
+		message << "CannotExtractException: " << e;
+		IloExtractableArray failed = e.getExtractables();
+		for (IloInt i = 0; i < failed.getSize(); ++i) {
+			message << "\n\t" << failed[i];
+		}
+		throw runtime_error( message.str() );
+	} catch( IloException& e ) {
+		stringstream message;
+		message << "CplexBackend: exception " << e;
+		throw runtime_error( message.str() );
+	}
+}
+
+void CplexBackend::setParameters()
+{
+	// turn off logging, otherwise print every node-log line with more details
+	if (logging) {
+		cplex.setParam( IloCplex::MIPInterval, 1 );
+		cplex.setParam( IloCplex::MIPDisplay, 2 );
+	} else {
+		cplex.setOut(env.getNullStream());
+	}
+	// only use a single thread unless a budget is given
+	cplex.setParam( IloCplex::Threads, threads > 0 ? (int)threads : 1 );
+	cplex.setParam( IloCplex::ParallelMode, parallelMode );
+	if (workMemory > 0) {
+		cplex.setParam( IloCplex::WorkMem, workMemory );
+	}
+	if (treeMemory > 0) {
+		cplex.setParam( IloCplex::TreLim, treeMemory );
+	}
+	if (timeLimit > 0) {
+		cplex.setParam( IloCplex::ClockType, 2 ); // wall clock
+		cplex.setParam( IloCplex::TiLim, timeLimit );
+	}
+}
+
+bool CplexBackend::solve()
+{
+	extract();
+	try {
+		setParameters();
+		reportedIncumbent = INF;
+		cplex.solve();
+		solved = true;
+
+		IloAlgorithm::Status status = cplex.getStatus();
+		optimal = (status == IloAlgorithm::Optimal);
+		feasible = optimal || status == IloAlgorithm::Feasible;
+	}
+	catch( IloException& e ) {
+		stringstream message;
+		message << "CplexBackend: exception " << e;
+		throw runtime_error( message.str() );
+	}
+	return feasible;
+}
+
+bool CplexBackend::isOptimal()
+{
+	return optimal;
+}
+
+string CplexBackend::getStatus()
+{
+	if (!solved) {
+		return "not solved";
+	}
+	stringstream status;
+	status << cplex.getStatus();
+	return status.str();
+}
+
+double CplexBackend::getObjectiveValue()
+{
+	return feasible ? cplex.getObjValue() : 0;
+}
+
+double CplexBackend::getBestBound()
+{
+	return solved ? cplex.getBestObjValue() : -INF;
+}
+
+double CplexBackend::getValue( int column )
+{
+	return feasible ? cplex.getValue(columns[column]) : 0;
+}
+
+int CplexBackend::getNodes()
+{
+	return solved ? cplex.getNnodes() : 0;
+}
+
+int CplexBackend::getCuts()
+{
+	int cuts = 0;
+	for (unsigned int i=0; solved && i<sizeof(CUT_TYPES) / sizeof(CUT_TYPES[0]); i++) {
+		cuts += cplex.getNcuts(CUT_TYPES[i]);
+	}
+	return cuts;
+}
+
+MILPBackend::Callback* CplexBackend::getCallback() const
+{
+	return callback;
+}
+
+bool CplexBackend::hasHook( Hook hook ) const
+{
+	return callback != NULL && (hooks & hook) != 0;
+}
+
+const IloNumVarArray& CplexBackend::getColumns() const
+{
+	return columns;
+}
+
+IloRange CplexBackend::toRange( const Row& row ) const
+{
+	IloExpr sum(env);
+	for (unsigned int i=0; i<row.expr.columns.size(); i++) {
+		sum += row.expr.values[i] * columns[ row.expr.columns[i] ];
+	}
+	IloRange range(env, toCplex(row.lb), sum, toCplex(row.ub));
+	sum.end();
+	return range;
+}
+
+bool CplexBackend::isNewIncumbent( double objective )
+{
+	pthread_mutex_lock(&incumbentMutex);
+	bool improved = objective < reportedIncumbent - 1e-9;
+	if (improved) {
+		reportedIncumbent = objective;
+	}
+	pthread_mutex_unlock(&incumbentMutex);
+	return improved;
+}
+
+#endif // KMST_CPLEX
@@ -0,0 +1,99 @@
+#ifndef __CPLEX_BACKEND__H__
+#define __CPLEX_BACKEND__H__
+
+#include "MILPBackend.h"
+
+using namespace std;
+
+#ifdef KMST_CPLEX
+
+#include <ilcplex/ilocplex.h>
+#include <pthread.h>
+
+ILOSTLBEGIN
+
+// MILPBackend on Concert (make CPLEX=1), columns and rows go into an IloModel which is extracted once;
+// errors of CPLEX are thrown as runtime_error, so the caller decides whether they end the process
+//
+// every hook is served by one CPLEX callback which hands the values of all columns to the Callback
+class CplexBackend : public MILPBackend
+{
+
+public:
+
+	CplexBackend();
+	~CplexBackend();
+
+	int addColumn( double lb, double ub, double cost, VarType type, string name );
+	void setBounds( int column, double lb, double ub );
+	int addRow( const Expr& expr, double lb, double ub );
+	int addRows( const RowBlock& block );
+	void setRowBounds( int row, double lb, double ub );
+	void setCoefficient( int row, int column, double value );
+
+	void setThreads( u_int _threads );
+	void setTimeLimit( double seconds );
+	void setParallelMode( int mode );
+	void setMemoryLimits( double _workMemory, double _treeMemory );
+	void setLogging( bool _logging );
+
+	void setCallback( Callback* _callback, int _hooks );
+	int getSupportedHooks() const;
+
+	void addMIPStart( const Expr& start );
+	void clearMIPStarts();
+	void abort();
+	void extract();
+
+	bool solve();
+	bool isOptimal();
+	string getStatus();
+	double getObjectiveValue();
+	double getBestBound();
+	double getValue( int column );
+	int getNodes();
+	int getCuts();
+
+	// used by the CPLEX callbacks
+	Callback* getCallback() const;
+	bool hasHook( Hook hook ) const;
+	const IloNumVarArray& getColumns() const;
+	IloRange toRange( const Row& row ) const;
+	bool isNewIncumbent( double objective ); // true once per improvement
+
+private:
+
+	IloEnv env;
+	IloModel model;
+	IloCplex cplex;
+	IloNumVarArray columns;
+	IloRangeArray rows;
+	IloLPMatrix matrix; // rows of addRows
+	int matrixFirstRow, matrixColumns; // -1 without matrix rows; columns known to the matrix
+	IloExpr objective;
+	IloCplex::Aborter aborter; // exists from the start, so abort works at any time
+
+	Callback* callback;
+	int hooks;
+
+	u_int threads;
+	double timeLimit;
+	int parallelMode;
+	double workMemory, treeMemory;
+	bool logging;
+
+	bool extracted, solved, feasible, optimal;
+	double reportedIncumbent; // of the running solve
+	pthread_mutex_t incumbentMutex;
+
+	void setParameters();
+
+	CplexBackend( const CplexBackend& );
+	CplexBackend& operator=( const CplexBackend& );
+
+};
+// CplexBackend
+
+#endif // KMST_CPLEX
+
+#endif //__CPLEX_BACKEND__H__
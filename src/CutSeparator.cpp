@@ -0,0 +1,120 @@
+#include "CutSeparator.h"
+
+#include "MaxFlow.h"
+
+CutSeparator::CutSeparator( const Instance& _instance ) :
+		instance( _instance )
+{
+}
+
+u_int CutSeparator::separateDirectedCuts( const vector<double>& arcValues,
+		const vector<double>& nodeValues, vector<DirectedCut>& cuts,
+		double minViolation ) const
+{
+	const u_int m = instance.n_edges;
+
+	// arc ids in the network coincide with the doubled arc layout
+	MaxFlow network(instance.n_nodes);
+	for (unsigned int i=0; i<m; i++) {
+		network.addArc(instance.edges[i].v1, instance.edges[i].v2, arcValues[i]);
+	}
+	for (unsigned int i=0; i<m; i++) {
+		network.addArc(instance.edges[i].v2, instance.edges[i].v1, arcValues[i + m]);
+	}
+
+	u_int found = 0;
+	for (u_int target=1; target<instance.n_nodes; target++) {
+		double demand = nodeValues[target];
+		if (demand <= minViolation) {
+			continue;
+		}
+
+		// root 0 has to send the demand of target through the arc capacities
+		double flow = network.solve(0, target, demand);
+		if (flow >= demand - minViolation) {
+			continue;
+		}
+
+		DirectedCut cut;
+		cut.target = target;
+		for (unsigned int i=0; i<2*m; i++) {
+			const Instance::Edge & edge = instance.edges[i % m];
+			u_int start = (i < m) ? edge.v1 : edge.v2;
+			u_int end = (i < m) ? edge.v2 : edge.v1;
+			if (network.isSourceSide(start) && !network.isSourceSide(end)) {
+				cut.arcs.push_back(i);
+			}
+		}
+		cuts.push_back(cut);
+		found++;
+	}
+
+	return found;
+}
+
+u_int CutSeparator::separateSubtourCuts( const vector<double>& edgeValues,
+		const vector<double>& nodeValues, vector<SubtourCut>& cuts,
+		double minViolation ) const
+{
+	const u_int n = instance.n_nodes, m = instance.n_edges;
+	const u_int source = n, sink = n + 1;
+	const double INF = 1e9;
+
+	// min over S containing t of y(S) - x(E(S)) equals the min cut below minus x(E):
+	// source -> v with x(delta(v))/2, v -> sink with y_v, both directions of e with x_e/2
+	MaxFlow network(n + 2);
+	vector<double> halfDegree(n, 0);
+	double edgeSum = 0;
+	for (unsigned int i=0; i<m; i++) {
+		const Instance::Edge & edge = instance.edges[i];
+		network.addArc(edge.v1, edge.v2, edgeValues[i] / 2);
+		network.addArc(edge.v2, edge.v1, edgeValues[i] / 2);
+		halfDegree[edge.v1] += edgeValues[i] / 2;
+		halfDegree[edge.v2] += edgeValues[i] / 2;
+		edgeSum += edgeValues[i];
+	}
+
+	vector<u_int> sourceArcs(n);
+	for (u_int v=0; v<n; v++) {
+		sourceArcs[v] = network.addArc(source, v, halfDegree[v]);
+		network.addArc(v, sink, nodeValues[v]);
+	}
+
+	u_int found = 0;
+	for (u_int target=0; target<n; target++) {
+		if (nodeValues[target] <= minViolation) {
+			continue;
+		}
+
+		// force target onto the source side
+		network.setCapacity(sourceArcs[target], INF);
+		double cutValue = network.solve(source, sink);
+		network.setCapacity(sourceArcs[target], halfDegree[target]);
+
+		if (cutValue - edgeSum >= nodeValues[target] - minViolation) {
+			continue;
+		}
+
+		SubtourCut cut;
+		cut.target = target;
+		for (u_int v=0; v<n; v++) {
+			if (network.isSourceSide(v)) {
+				cut.vertices.push_back(v);
+			}
+		}
+		for (unsigned int i=0; i<m; i++) {
+			if (network.isSourceSide(instance.edges[i].v1) && network.isSourceSide(instance.edges[i].v2)) {
+				cut.edges.push_back(i);
+			}
+		}
+
+		// a single vertex can't violate anything, this only shows up through rounding
+		if (cut.edges.empty()) {
+			continue;
+		}
+		cuts.push_back(cut);
+		found++;
+	}
+
+	return found;
+}
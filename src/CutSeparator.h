@@ -0,0 +1,52 @@
+#ifndef __CUT_SEPARATOR__H__
+#define __CUT_SEPARATOR__H__
+
+#include "Instance.h"
+
+#include <vector>
+
+using namespace std;
+
+// finds violated connectivity inequalities for given (fractional) solutions
+// results are plain index lists, turning them into constraints is up to the model
+class CutSeparator
+{
+
+public:
+
+	// directed cut: sum of arcs leaving the root set >= node variable of target
+	struct DirectedCut
+	{
+		u_int target;
+		vector<u_int> arcs; // ids in the doubled arc layout of kMST_ILP
+	};
+
+	// generalized subtour elimination: sum of edges inside S <= sum of node variables of S without target
+	struct SubtourCut
+	{
+		u_int target;
+		vector<u_int> vertices; // S, contains target
+		vector<u_int> edges; // edge ids with both ends in S
+	};
+
+	CutSeparator( const Instance& _instance );
+
+	// arcValues: 2m values (first half v1->v2, second half v2->v1), nodeValues: n values
+	// returns number of cuts found, violation has to exceed minViolation
+	u_int separateDirectedCuts( const vector<double>& arcValues,
+			const vector<double>& nodeValues, vector<DirectedCut>& cuts,
+			double minViolation ) const;
+
+	// edgeValues: m values of the undirected edges, nodeValues: n values
+	u_int separateSubtourCuts( const vector<double>& edgeValues,
+			const vector<double>& nodeValues, vector<SubtourCut>& cuts,
+			double minViolation ) const;
+
+private:
+
+	const Instance& instance;
+
+};
+// CutSeparator
+
+#endif //__CUT_SEPARATOR__H__
@@ -0,0 +1,324 @@
+#ifndef __GENERATE__CPP__
+#define __GENERATE__CPP__
+
+#include <iostream>
+#include <fstream>
+#include <cstdlib>
+#include <cmath>
+#include <set>
+#include <vector>
+#include <unistd.h>
+#include "Instance.h"
+
+using namespace std;
+
+void usage()
+{
+	cout << "USAGE:\t<program> -t type -n <vertices> -o <file> [-d <average degree> -w uniform|exponential|euclidean\n";
+	cout << "\t\t-W <max weight> -c <clusters> -s <seed>]\n";
+	cout << "TYPES:\tgeometric (random points in the unit square, neighbours within a radius),\n";
+	cout << "\tgrid (4-neighbourhood, diagonals with probability (d-4)/4), scalefree (preferential attachment),\n";
+	cout << "\tclustered (dense random clusters joined by few expensive edges)\n";
+	cout << "\twrites the .dat format including the edges of the artificial root 0, components are joined\n";
+	cout << "\tby extra edges so the graph is connected; euclidean weights are only for geometric and clustered\n";
+	cout << "EXAMPLE:\t" << "./kmst-generate -t geometric -n 10000 -d 8 -w euclidean -s 1 -o data/generated/geometric-10000.dat\n\n";
+	exit( 1 );
+} // usage
+
+// xorshift64*, the same sequence on every platform
+struct Random
+{
+	unsigned long long state;
+
+	Random( unsigned long long seed ) : state( seed * 2685821657736338717ULL + 1 ) {}
+
+	unsigned long long next()
+	{
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return state * 2685821657736338717ULL;
+	}
+
+	double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); } // [0, 1)
+	u_int below( u_int bound ) { return (u_int)(uniform() * bound); }
+};
+
+struct Generator
+{
+	u_int n; // real vertices 1..n
+	double degree;
+	string weights;
+	int maxWeight;
+	u_int clusters;
+	Random random;
+
+	vector<double> x, y; // positions for euclidean weights, empty if there are none
+	double reach; // longest distance of a regular edge, it gets maxWeight
+	vector<u_int> v1, v2;
+	vector<int> weight;
+	set<unsigned long long> present;
+
+	Generator( u_int _n, double _degree, string _weights, int _maxWeight, u_int _clusters, unsigned long long seed ) :
+			n( _n ), degree( _degree ), weights( _weights ), maxWeight( _maxWeight ), clusters( _clusters ),
+			random( seed ), reach( sqrt(2.0) )
+	{
+	}
+
+	int drawWeight( u_int a, u_int b, double factor )
+	{
+		double w;
+		if (weights == "euclidean" && !x.empty()) {
+			// relative to the reach, so that the weights use 1..maxWeight, longer edges (bridges) are capped
+			w = sqrt((x[a] - x[b]) * (x[a] - x[b]) + (y[a] - y[b]) * (y[a] - y[b])) / reach * maxWeight;
+		} else if (weights == "exponential") {
+			w = -log(1 - random.uniform()) * maxWeight / 8;
+		} else {
+			w = random.uniform() * maxWeight;
+		}
+		return max(1, min(maxWeight, (int)ceil(w * factor)));
+	}
+
+	// false if it exists already or is a loop
+	bool addEdge( u_int a, u_int b, double factor = 1 )
+	{
+		if (a == b) {
+			return false;
+		}
+		unsigned long long key = (unsigned long long)min(a, b) * (n + 1) + max(a, b);
+		if (!present.insert(key).second) {
+			return false;
+		}
+		v1.push_back(a);
+		v2.push_back(b);
+		weight.push_back(drawWeight(a, b, factor));
+		return true;
+	}
+
+	void placePoints()
+	{
+		x.resize(n + 1);
+		y.resize(n + 1);
+		for (u_int v=1; v<=n; v++) {
+			x[v] = random.uniform();
+			y[v] = random.uniform();
+		}
+	}
+
+	void geometric()
+	{
+		placePoints();
+
+		// expected degree n * pi * r^2, neighbours are searched in the surrounding cells of size r
+		double radius = sqrt(degree / (M_PI * n));
+		reach = radius;
+		u_int cells = max(1u, (u_int)(1 / radius));
+		vector<vector<u_int> > grid(cells * cells);
+		for (u_int v=1; v<=n; v++) {
+			u_int cx = min(cells - 1, (u_int)(x[v] * cells)), cy = min(cells - 1, (u_int)(y[v] * cells));
+			grid[cy * cells + cx].push_back(v);
+		}
+		for (u_int v=1; v<=n; v++) {
+			int cx = min(cells - 1, (u_int)(x[v] * cells)), cy = min(cells - 1, (u_int)(y[v] * cells));
+			for (int dy=-1; dy<=1; dy++) {
+				for (int dx=-1; dx<=1; dx++) {
+					if (cx + dx < 0 || cy + dy < 0 || cx + dx >= (int)cells || cy + dy >= (int)cells) {
+						continue;
+					}
+					const vector<u_int>& cell = grid[(cy + dy) * cells + cx + dx];
+					for (unsigned int i=0; i<cell.size(); i++) {
+						u_int w = cell[i];
+						if (w > v && (x[v] - x[w]) * (x[v] - x[w]) + (y[v] - y[w]) * (y[v] - y[w]) <= radius * radius) {
+							addEdge(v, w);
+						}
+					}
+				}
+			}
+		}
+	}
+
+	void grid()
+	{
+		u_int columns = max(1u, (u_int)ceil(sqrt((double)n)));
+		double diagonal = max(0.0, min(1.0, (degree - 4) / 4));
+		for (u_int v=1; v<=n; v++) {
+			u_int column = (v - 1) % columns;
+			if (column + 1 < columns && v + 1 <= n) {
+				addEdge(v, v + 1);
+			}
+			if (v + columns <= n) {
+				addEdge(v, v + columns);
+			}
+			if (column + 1 < columns && v + columns + 1 <= n && random.uniform() < diagonal) {
+				addEdge(v, v + columns + 1);
+			}
+			if (column > 0 && v + columns - 1 <= n && random.uniform() < diagonal) {
+				addEdge(v, v + columns - 1);
+			}
+		}
+	}
+
+	void scaleFree()
+	{
+		// every new vertex attaches to d/2 vertices chosen proportionally to their degree
+		u_int attach = max(1u, (u_int)(degree / 2 + 0.5));
+		vector<u_int> endpoints; // every vertex once per incident edge
+		u_int seedVertices = min(n, attach + 1);
+		for (u_int v=1; v<=seedVertices; v++) {
+			for (u_int w=v+1; w<=seedVertices; w++) {
+				addEdge(v, w);
+				endpoints.push_back(v);
+				endpoints.push_back(w);
+			}
+		}
+		for (u_int v=seedVertices+1; v<=n; v++) {
+			u_int added = 0;
+			for (u_int tries=0; added < attach && tries < 10 * attach; tries++) {
+				u_int w = endpoints.empty() ? 1 + random.below(v - 1) : endpoints[ random.below(endpoints.size()) ];
+				if (addEdge(v, w)) {
+					endpoints.push_back(v);
+					endpoints.push_back(w);
+					added++;
+				}
+			}
+		}
+	}
+
+	void clustered()
+	{
+		// cluster centers with points around them, 90% of the edges stay within a cluster
+		u_int count = max(1u, min(clusters, n));
+		vector<double> cx(count), cy(count);
+		for (u_int c=0; c<count; c++) {
+			cx[c] = random.uniform();
+			cy[c] = random.uniform();
+		}
+		vector<vector<u_int> > members(count);
+		vector<u_int> cluster(n + 1);
+		x.resize(n + 1);
+		y.resize(n + 1);
+		double spread = 0.5 / sqrt((double)count);
+		reach = spread * sqrt(2.0); // diagonal of a cluster
+		for (u_int v=1; v<=n; v++) {
+			cluster[v] = random.below(count);
+			members[ cluster[v] ].push_back(v);
+			x[v] = max(0.0, min(1.0, cx[ cluster[v] ] + (random.uniform() - 0.5) * spread));
+			y[v] = max(0.0, min(1.0, cy[ cluster[v] ] + (random.uniform() - 0.5) * spread));
+		}
+
+		unsigned long long inside = (unsigned long long)(0.9 * degree * n / 2);
+		unsigned long long between = (unsigned long long)(0.1 * degree * n / 2);
+		for (unsigned long long tries=0, added=0; added < inside && tries < 10 * inside; tries++) {
+			u_int v = 1 + random.below(n);
+			const vector<u_int>& own = members[ cluster[v] ];
+			if (addEdge(v, own[ random.below(own.size()) ])) {
+				added++;
+			}
+		}
+		for (unsigned long long tries=0, added=0; added < between && tries < 10 * between; tries++) {
+			// expensive bridges make the clusters the natural solutions
+			u_int v = 1 + random.below(n), w = 1 + random.below(n);
+			if (cluster[v] != cluster[w] && addEdge(v, w, 3)) {
+				added++;
+			}
+		}
+	}
+
+	u_int find( vector<u_int>& parent, u_int v )
+	{
+		while (parent[v] != v) {
+			parent[v] = parent[ parent[v] ];
+			v = parent[v];
+		}
+		return v;
+	}
+
+	// joins every component to a random vertex of the ones before it
+	void connect()
+	{
+		vector<u_int> parent(n + 1);
+		for (u_int v=0; v<=n; v++) {
+			parent[v] = v;
+		}
+		for (unsigned int i=0; i<v1.size(); i++) {
+			parent[ find(parent, v1[i]) ] = find(parent, v2[i]);
+		}
+		for (u_int v=2; v<=n; v++) {
+			if (find(parent, v) != find(parent, 1)) {
+				u_int w = 1 + random.below(v - 1);
+				addEdge(v, w);
+				parent[ find(parent, v) ] = find(parent, w);
+			}
+		}
+	}
+
+	void write( string file )
+	{
+		ofstream out( file.c_str() );
+		if( out.fail() ) {
+			cerr << "could not open output file " << file << "\n";
+			exit( -1 );
+		}
+
+		// edges of the artificial root first, as in the bundled instances
+		out << n + 1 << "\n" << n + v1.size() << "\n";
+		for (u_int v=1; v<=n; v++) {
+			out << v - 1 << " 0 " << v << " 0\n";
+		}
+		for (unsigned int i=0; i<v1.size(); i++) {
+			out << n + i << " " << v1[i] << " " << v2[i] << " " << weight[i] << "\n";
+		}
+		out.close();
+	}
+};
+
+int main( int argc, char *argv[] )
+{
+	int opt;
+	string type(""), file(""), weights("uniform");
+	u_int n = 0, clusters = 10;
+	double degree = 6;
+	int maxWeight = 100;
+	unsigned long long seed = 1;
+	while( (opt = getopt( argc, argv, "t:n:o:d:w:W:c:s:" )) != EOF) {
+		switch( opt ) {
+			case 't': type = optarg; break;
+			case 'n': n = atoi( optarg ); break;
+			case 'o': file = optarg; break;
+			case 'd': degree = atof( optarg ); break;
+			case 'w': weights = optarg; break;
+			case 'W': maxWeight = max(atoi( optarg ), 1); break;
+			case 'c': clusters = max(atoi( optarg ), 1); break;
+			case 's': seed = strtoull( optarg, NULL, 10 ); break;
+			default: usage(); break;
+		}
+	}
+	if (type.empty() || file.empty() || n < 2) {
+		usage();
+	}
+	if (weights != "uniform" && weights != "exponential" && weights != "euclidean") {
+		cerr << "unknown weight distribution " << weights << "\n";
+		exit( -1 );
+	}
+
+	Generator generator( n, degree, weights, maxWeight, clusters, seed );
+	if (type == "geometric") {
+		generator.geometric();
+	} else if (type == "grid") {
+		generator.grid();
+	} else if (type == "scalefree") {
+		generator.scaleFree();
+	} else if (type == "clustered") {
+		generator.clustered();
+	} else {
+		cerr << "unknown graph type " << type << "\n";
+		exit( -1 );
+	}
+	generator.connect();
+	generator.write( file );
+
+	cout << "Written " << file << ": " << n << " vertices, " << generator.v1.size() << " edges\n";
+	return 0;
+} // main
+
+#endif // __GENERATE__CPP__
@@ -0,0 +1,457 @@
+#include "Heuristic.h"
+
+#include <queue>
+#include <algorithm>
+#include <climits>
+#include <pthread.h>
+
+KTree::KTree() : weight( INT_MAX )
+{
+}
+
+bool KTree::isValid() const
+{
+	return weight != INT_MAX;
+}
+
+KTreeHeuristic::KTreeHeuristic( const Instance& _instance, int _k ) :
+		instance( _instance ), k( _k )
+{
+}
+
+bool KTreeHeuristic::isRealEdge( u_int edge ) const
+{
+	return instance.edges[edge].v1 != 0 && instance.edges[edge].v2 != 0;
+}
+
+KTree KTreeHeuristic::grow( u_int root ) const
+{
+	KTree tree;
+	tree.vertices.push_back(root);
+	tree.weight = 0;
+	if (!extend(tree)) {
+		return KTree(); // component of root has less than k vertices
+	}
+	return tree;
+}
+
+bool KTreeHeuristic::extend( KTree& tree ) const
+{
+	typedef pair<int, u_int> Candidate; // weight, edge id
+	priority_queue<Candidate, vector<Candidate>, greater<Candidate> > candidates;
+	vector<bool> inTree(instance.n_nodes, false);
+	for (unsigned int i=0; i<tree.vertices.size(); i++) {
+		inTree[ tree.vertices[i] ] = true;
+	}
+
+	// all edges leaving the tree are offered first, afterwards the ones of the vertex added last
+	vector<u_int> offer = tree.vertices;
+	while ((int)tree.vertices.size() < k) {
+		for (unsigned int i=0; i<offer.size(); i++) {
+			u_int vertex = offer[i];
+			for (const u_int* iter = instance.incidentEdges(vertex).begin();
+					 iter != instance.incidentEdges(vertex).end(); ++iter) {
+				const Instance::Edge & edge = instance.edges[*iter];
+				u_int other = (edge.v1 == vertex) ? edge.v2 : edge.v1;
+				if (!inTree[other] && isRealEdge(*iter)) {
+					candidates.push(Candidate(edge.weight, *iter));
+				}
+			}
+		}
+		offer.clear();
+
+		// cheapest edge which still leads outside
+		while (!candidates.empty()) {
+			const Instance::Edge & edge = instance.edges[ candidates.top().second ];
+			if (!inTree[edge.v1] || !inTree[edge.v2]) {
+				break;
+			}
+			candidates.pop();
+		}
+		if (candidates.empty()) {
+			return false;
+		}
+
+		u_int edgeId = candidates.top().second;
+		candidates.pop();
+		const Instance::Edge & edge = instance.edges[edgeId];
+		u_int vertex = inTree[edge.v1] ? edge.v2 : edge.v1;
+
+		inTree[vertex] = true;
+		tree.vertices.push_back(vertex);
+		tree.edges.push_back(edgeId);
+		tree.weight += edge.weight;
+		offer.push_back(vertex);
+	}
+	return true;
+}
+
+KTree KTreeHeuristic::resize( const KTree& tree ) const
+{
+	if (!tree.isValid() || tree.vertices.empty()) {
+		return KTree();
+	}
+
+	KTree result = tree;
+
+	// shrinking: removing a leaf keeps the rest connected
+	while ((int)result.vertices.size() > k) {
+		vector<u_int> degree(instance.n_nodes, 0);
+		for (unsigned int i=0; i<result.edges.size(); i++) {
+			degree[ instance.edges[ result.edges[i] ].v1 ]++;
+			degree[ instance.edges[ result.edges[i] ].v2 ]++;
+		}
+
+		int worstWeight = -1;
+		u_int worstIndex = 0, leaf = 0;
+		for (unsigned int i=0; i<result.edges.size(); i++) {
+			const Instance::Edge & edge = instance.edges[ result.edges[i] ];
+			if (edge.weight > worstWeight && (degree[edge.v1] == 1 || degree[edge.v2] == 1)) {
+				worstWeight = edge.weight;
+				worstIndex = i;
+				leaf = (degree[edge.v1] == 1) ? edge.v1 : edge.v2;
+			}
+		}
+		if (worstWeight < 0) {
+			result.vertices.resize(k); // no edges, so the vertices are isolated anyway
+			break;
+		}
+
+		result.weight -= worstWeight;
+		result.edges.erase(result.edges.begin() + worstIndex);
+		result.vertices.erase(find(result.vertices.begin(), result.vertices.end(), leaf));
+	}
+
+	if (!extend(result)) {
+		return KTree();
+	}
+	return result;
+}
+
+KTree KTreeHeuristic::spanningTree( const vector<u_int>& vertices ) const
+{
+	vector<bool> selected(instance.n_nodes, false);
+	for (unsigned int i=0; i<vertices.size(); i++) {
+		selected[ vertices[i] ] = true;
+	}
+
+	// induced edges by weight
+	vector<pair<int, u_int> > induced;
+	for (u_int e=0; e<instance.n_edges; e++) {
+		if (selected[ instance.edges[e].v1 ] && selected[ instance.edges[e].v2 ] && isRealEdge(e)) {
+			induced.push_back(pair<int, u_int>(instance.edges[e].weight, e));
+		}
+	}
+	sort(induced.begin(), induced.end());
+
+	// kruskal with union-find (path halving)
+	vector<u_int> parent(instance.n_nodes);
+	for (u_int v=0; v<instance.n_nodes; v++) {
+		parent[v] = v;
+	}
+
+	KTree tree;
+	tree.vertices = vertices;
+	int weight = 0;
+	for (unsigned int i=0; i<induced.size() && tree.edges.size() + 1 < vertices.size(); i++) {
+		u_int a = instance.edges[ induced[i].second ].v1, b = instance.edges[ induced[i].second ].v2;
+		while (parent[a] != a) a = parent[a] = parent[ parent[a] ];
+		while (parent[b] != b) b = parent[b] = parent[ parent[b] ];
+		if (a == b) {
+			continue;
+		}
+		parent[a] = b;
+		tree.edges.push_back(induced[i].second);
+		weight += induced[i].first;
+	}
+
+	if (tree.edges.size() + 1 == vertices.size()) {
+		tree.weight = weight;
+	}
+	return tree;
+}
+
+void KTreeHeuristic::improve( KTree& tree ) const
+{
+	while (tree.isValid() && !tree.edges.empty()) {
+		swapLeaves(tree);
+
+		// swaps may leave the tree more expensive than the mst on its vertices
+		KTree spanning = spanningTree(tree.vertices);
+		if (spanning.weight >= tree.weight) {
+			break;
+		}
+		tree = spanning;
+	}
+}
+
+void KTreeHeuristic::swapLeaves( KTree& tree ) const
+{
+	const int MAX_SWAPS = 10000;
+
+	vector<bool> inTree(instance.n_nodes, false);
+	vector<u_int> degree(instance.n_nodes, 0);
+	for (unsigned int i=0; i<tree.vertices.size(); i++) {
+		inTree[ tree.vertices[i] ] = true;
+	}
+	for (unsigned int i=0; i<tree.edges.size(); i++) {
+		degree[ instance.edges[ tree.edges[i] ].v1 ]++;
+		degree[ instance.edges[ tree.edges[i] ].v2 ]++;
+	}
+
+	vector<u_int> leaving;
+	for (int swap=0; swap<MAX_SWAPS; swap++) {
+		// edges leaving the tree from its adjacency instead of all edges, in id order as ties depend on it
+		leaving.clear();
+		for (unsigned int i=0; i<tree.vertices.size(); i++) {
+			Instance::Span incident = instance.incidentEdges( tree.vertices[i] );
+			for (const u_int* iter = incident.begin(); iter != incident.end(); ++iter) {
+				const Instance::Edge & edge = instance.edges[*iter];
+				if (inTree[edge.v1] != inTree[edge.v2] && isRealEdge(*iter)) {
+					leaving.push_back(*iter);
+				}
+			}
+		}
+		sort(leaving.begin(), leaving.end());
+
+		// two cheapest edges entering the tree at different vertices
+		int bestWeight[2] = { INT_MAX, INT_MAX };
+		u_int bestEdge[2] = { 0, 0 }, bestAttach[2] = { 0, 0 };
+
+		for (unsigned int i=0; i<leaving.size(); i++) {
+			u_int e = leaving[i];
+			const Instance::Edge & edge = instance.edges[e];
+			u_int attach = inTree[edge.v1] ? edge.v1 : edge.v2;
+
+			if (edge.weight < bestWeight[0]) {
+				if (attach != bestAttach[0]) {
+					bestWeight[1] = bestWeight[0];
+					bestEdge[1] = bestEdge[0];
+					bestAttach[1] = bestAttach[0];
+				}
+				bestWeight[0] = edge.weight;
+				bestEdge[0] = e;
+				bestAttach[0] = attach;
+			} else if (edge.weight < bestWeight[1] && attach != bestAttach[0]) {
+				bestWeight[1] = edge.weight;
+				bestEdge[1] = e;
+				bestAttach[1] = attach;
+			}
+		}
+
+		// leaf whose removal saves most compared to the insertion it allows
+		int bestGain = 0;
+		u_int leaf = 0, leafEdgeIndex = 0, insertIndex = 0;
+		for (unsigned int i=0; i<tree.edges.size(); i++) {
+			const Instance::Edge & edge = instance.edges[ tree.edges[i] ];
+			u_int leaves[2] = { edge.v1, edge.v2 };
+			for (int j=0; j<2; j++) {
+				if (degree[ leaves[j] ] != 1) {
+					continue;
+				}
+				int candidate = (bestAttach[0] != leaves[j]) ? 0 : 1;
+				if (bestWeight[candidate] == INT_MAX) {
+					continue;
+				}
+				int gain = edge.weight - bestWeight[candidate];
+				if (gain > bestGain) {
+					bestGain = gain;
+					leaf = leaves[j];
+					leafEdgeIndex = i;
+					insertIndex = candidate;
+				}
+			}
+		}
+
+		if (bestGain <= 0) {
+			break;
+		}
+
+		// remove leaf
+		const Instance::Edge & oldEdge = instance.edges[ tree.edges[leafEdgeIndex] ];
+		degree[oldEdge.v1]--;
+		degree[oldEdge.v2]--;
+		inTree[leaf] = false;
+		tree.vertices.erase(find(tree.vertices.begin(), tree.vertices.end(), leaf));
+
+		// insert new vertex
+		const Instance::Edge & newEdge = instance.edges[ bestEdge[insertIndex] ];
+		u_int added = (newEdge.v1 == bestAttach[insertIndex]) ? newEdge.v2 : newEdge.v1;
+		degree[newEdge.v1]++;
+		degree[newEdge.v2]++;
+		inTree[added] = true;
+		tree.vertices.push_back(added);
+		tree.edges[leafEdgeIndex] = bestEdge[insertIndex];
+		tree.weight -= bestGain;
+	}
+}
+
+KTree KTreeHeuristic::repair( const vector<double>& edgeValues ) const
+{
+	if (k <= 1) {
+		return KTree(); // single vertices, the start heuristic is optimal
+	}
+
+	// edges of the LP support first, ties by weight
+	vector<pair<pair<double, int>, u_int> > order;
+	for (u_int e=0; e<instance.n_edges; e++) {
+		if (isRealEdge(e)) {
+			double value = min(max(edgeValues[e], 0.0), 1.0);
+			int weight = instance.edges[e].weight;
+			order.push_back(make_pair(make_pair((1 - value) * weight, weight), e));
+		}
+	}
+	sort(order.begin(), order.end());
+
+	vector<u_int> parent(instance.n_nodes), size(instance.n_nodes, 1);
+	for (u_int v=0; v<instance.n_nodes; v++) {
+		parent[v] = v;
+	}
+	int component = -1;
+	for (unsigned int i=0; i<order.size() && component < 0; i++) {
+		u_int a = instance.edges[ order[i].second ].v1, b = instance.edges[ order[i].second ].v2;
+		while (parent[a] != a) a = parent[a] = parent[ parent[a] ];
+		while (parent[b] != b) b = parent[b] = parent[ parent[b] ];
+		if (a == b) {
+			continue;
+		}
+		parent[a] = b;
+		size[b] += size[a];
+		if ((int)size[b] >= k) {
+			component = b;
+		}
+	}
+	if (component < 0) {
+		return KTree(); // no component with k vertices
+	}
+
+	vector<u_int> vertices;
+	for (u_int v=1; v<instance.n_nodes; v++) {
+		u_int root = v;
+		while (parent[root] != root) root = parent[root];
+		if ((int)root == component) {
+			vertices.push_back(v);
+		}
+	}
+
+	KTree tree = resize(spanningTree(vertices));
+	improve(tree);
+	return tree;
+}
+
+// ----- parallel search over start vertices ---------------------------
+
+struct HeuristicWorker
+{
+	const KTreeHeuristic* heuristic;
+	pthread_mutex_t* mutex;
+	const vector<u_int>* roots;
+	u_int* nextRoot; // index into roots
+	KTree best;
+	u_int bestRoot;
+};
+
+static void* runHeuristicWorker( void* arg )
+{
+	HeuristicWorker* worker = (HeuristicWorker*)arg;
+
+	while (true) {
+		pthread_mutex_lock(worker->mutex);
+		u_int next = (*worker->nextRoot)++;
+		pthread_mutex_unlock(worker->mutex);
+
+		if (next >= worker->roots->size()) {
+			break;
+		}
+		u_int root = (*worker->roots)[next];
+
+		KTree tree = worker->heuristic->grow(root);
+		worker->heuristic->improve(tree);
+
+		// ties are broken by root so the result doesn't depend on scheduling
+		if (tree.weight < worker->best.weight ||
+				(tree.isValid() && tree.weight == worker->best.weight && root < worker->bestRoot)) {
+			worker->best = tree;
+			worker->bestRoot = root;
+		}
+	}
+	return NULL;
+}
+
+KTree KTreeHeuristic::solve( u_int threads ) const
+{
+	if (threads < 1) {
+		threads = 1;
+	}
+
+	// every vertex on small graphs (all bundled instances), otherwise half of the roots are the
+	// vertices with the cheapest incident edges and half are spread evenly over the ids
+	const u_int MAX_ROOTS = 400;
+	vector<u_int> roots;
+	if (instance.n_nodes - 1 <= MAX_ROOTS) {
+		for (u_int v=1; v<instance.n_nodes; v++) {
+			roots.push_back(v);
+		}
+	} else {
+		vector<pair<int, u_int> > cheapest;
+		for (u_int v=1; v<instance.n_nodes; v++) {
+			int weight = INT_MAX;
+			Instance::Span incident = instance.incidentEdges(v);
+			for (const u_int* iter = incident.begin(); iter != incident.end(); ++iter) {
+				if (isRealEdge(*iter)) {
+					weight = min(weight, instance.edges[*iter].weight);
+				}
+			}
+			cheapest.push_back(pair<int, u_int>(weight, v));
+		}
+		partial_sort(cheapest.begin(), cheapest.begin() + MAX_ROOTS / 2, cheapest.end());
+		vector<bool> chosen(instance.n_nodes, false);
+		for (u_int i=0; i<MAX_ROOTS / 2; i++) {
+			chosen[ cheapest[i].second ] = true;
+		}
+		for (u_int i=0; i<MAX_ROOTS / 2; i++) {
+			chosen[ 1 + (u_int)((unsigned long long)i * (instance.n_nodes - 1) / (MAX_ROOTS / 2)) ] = true;
+		}
+		for (u_int v=1; v<instance.n_nodes; v++) {
+			if (chosen[v]) {
+				roots.push_back(v);
+			}
+		}
+	}
+
+	pthread_mutex_t mutex;
+	pthread_mutex_init(&mutex, NULL);
+	u_int nextRoot = 0;
+
+	vector<HeuristicWorker> workers(threads);
+	vector<pthread_t> handles(threads);
+	for (u_int i=0; i<threads; i++) {
+		workers[i].heuristic = this;
+		workers[i].mutex = &mutex;
+		workers[i].roots = &roots;
+		workers[i].nextRoot = &nextRoot;
+		workers[i].bestRoot = instance.n_nodes;
+	}
+
+	// worker 0 runs in the calling thread
+	for (u_int i=1; i<threads; i++) {
+		pthread_create(&handles[i], NULL, runHeuristicWorker, &workers[i]);
+	}
+	runHeuristicWorker(&workers[0]);
+
+	KTree best;
+	u_int bestRoot = instance.n_nodes;
+	for (u_int i=0; i<threads; i++) {
+		if (i > 0) {
+			pthread_join(handles[i], NULL);
+		}
+		if (workers[i].best.weight < best.weight ||
+				(workers[i].best.isValid() && workers[i].best.weight == best.weight && workers[i].bestRoot < bestRoot)) {
+			best = workers[i].best;
+			bestRoot = workers[i].bestRoot;
+		}
+	}
+
+	pthread_mutex_destroy(&mutex);
+	return best;
+}
@@ -0,0 +1,66 @@
+#ifndef __HEURISTIC__H__
+#define __HEURISTIC__H__
+
+#include "Instance.h"
+
+#include <vector>
+
+using namespace std;
+
+// a k-tree given by its real edges, the artificial root 0 is not part of it
+struct KTree
+{
+	vector<u_int> vertices;
+	vector<u_int> edges; // ids in instance.edges, none incident to node 0
+	int weight;
+
+	KTree();
+	bool isValid() const;
+};
+
+// greedy k-tree construction: Prim-style growth from start vertices followed by leaf swaps
+class KTreeHeuristic
+{
+
+public:
+
+	KTreeHeuristic( const Instance& _instance, int _k );
+
+	// best tree over the start vertices (all of them up to 400, a cheap and spread subset beyond), distributed over threads
+	KTree solve( u_int threads = 1 ) const;
+
+	// grow a tree from root by always adding the cheapest edge leaving it
+	KTree grow( u_int root ) const;
+
+	// tree with k vertices from a tree of another size (e.g. a solution for a neighbouring k):
+	// the most expensive leaves are removed or the tree grows like in grow
+	KTree resize( const KTree& tree ) const;
+
+	// leaf swaps alternating with mst recomputation until neither improves
+	void improve( KTree& tree ) const;
+
+	// replace expensive leaves by cheaper outside vertices until no swap improves
+	void swapLeaves( KTree& tree ) const;
+
+	// tree guided by an LP point, values per edge in [0,1]: kruskal on (1 - value) * weight until a
+	// component has k vertices, its mst cut down to k by the most expensive leaves and improved
+	KTree repair( const vector<double>& edgeValues ) const;
+
+	// minimum spanning tree on the subgraph induced by vertices (invalid if disconnected)
+	KTree spanningTree( const vector<u_int>& vertices ) const;
+
+	// true if edge is not incident to the artificial root
+	bool isRealEdge( u_int edge ) const;
+
+private:
+
+	const Instance& instance;
+	int k;
+
+	// adds cheapest leaving edges until the tree has k vertices, false if it can't
+	bool extend( KTree& tree ) const;
+
+};
+// KTreeHeuristic
+
+#endif //__HEURISTIC__H__
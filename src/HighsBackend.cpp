@@ -0,0 +1,247 @@
+#include "HighsBackend.h"
+
+#ifdef KMST_HIGHS
+
+#include <interfaces/highs_c_api.h>
+
+HighsBackend::HighsBackend() :
+		columns( 0 ), rows( 0 ), aborted( false ), solved( false ), feasible( false ), optimal( false )
+{
+	highs = Highs_create();
+	infinity = Highs_getInfinity(highs);
+	Highs_setBoolOptionValue(highs, "output_flag", 0);
+	Highs_setIntOptionValue(highs, "threads", 1);
+	// mip_rel_gap is left at 1e-4, the default of HiGHS and CPLEX alike
+}
+
+HighsBackend::~HighsBackend()
+{
+	Highs_destroy(highs);
+}
+
+double HighsBackend::toHighs( double bound )
+{
+	return bound >= INF ? infinity : (bound <= -INF ? -infinity : bound);
+}
+
+int HighsBackend::addColumn( double lb, double ub, double cost, VarType type, string name )
+{
+	if (type == BINARY) {
+		lb = max(lb, 0.0);
+		ub = min(ub, 1.0);
+	}
+	Highs_addCol(highs, cost, toHighs(lb), toHighs(ub), 0, NULL, NULL);
+	if (type != CONTINUOUS) {
+		Highs_changeColIntegrality(highs, columns, kHighsVarTypeInteger);
+	}
+	return columns++;
+}
+
+void HighsBackend::setBounds( int column, double lb, double ub )
+{
+	Highs_changeColBounds(highs, column, toHighs(lb), toHighs(ub));
+}
+
+int HighsBackend::addRow( const Expr& expr, double lb, double ub )
+{
+	// HiGHS rejects repeated indices, so coefficients of a column are summed first
+	vector<pair<int, double> > entries;
+	for (unsigned int i=0; i<expr.columns.size(); i++) {
+		entries.push_back(pair<int, double>(expr.columns[i], expr.values[i]));
+	}
+	sort(entries.begin(), entries.end());
+	vector<HighsInt> indices;
+	vector<double> coefficients;
+	for (unsigned int i=0; i<entries.size(); i++) {
+		if (!indices.empty() && indices.back() == entries[i].first) {
+			coefficients.back() += entries[i].second;
+		} else {
+			indices.push_back(entries[i].first);
+			coefficients.push_back(entries[i].second);
+		}
+	}
+	Highs_addRow(highs, toHighs(lb), toHighs(ub), indices.size(),
+			indices.empty() ? NULL : &indices[0], coefficients.empty() ? NULL : &coefficients[0]);
+	return rows++;
+}
+
+// the rows of a block have distinct columns, so they go to HiGHS as they are
+int HighsBackend::addRows( const RowBlock& block )
+{
+	HighsInt count = block.lb.size();
+	if (count == 0) {
+		return rows;
+	}
+	vector<double> lb(count), ub(count);
+	vector<HighsInt> starts(block.begin.begin(), block.begin.begin() + count);
+	vector<HighsInt> indices(block.columns.begin(), block.columns.end());
+	for (HighsInt row=0; row<count; row++) {
+		lb[row] = toHighs(block.lb[row]);
+		ub[row] = toHighs(block.ub[row]);
+	}
+	Highs_addRows(highs, count, &lb[0], &ub[0], indices.size(), &starts[0],
+			indices.empty() ? NULL : &indices[0], block.values.empty() ? NULL : &block.values[0]);
+	int first = rows;
+	rows += count;
+	return first;
+}
+
+void HighsBackend::setRowBounds( int row, double lb, double ub )
+{
+	Highs_changeRowBounds(highs, row, toHighs(lb), toHighs(ub));
+}
+
+void HighsBackend::setCoefficient( int row, int column, double value )
+{
+	Highs_changeCoeff(highs, row, column, value);
+}
+
+void HighsBackend::setThreads( u_int _threads )
+{
+	Highs_setIntOptionValue(highs, "threads", _threads > 0 ? (HighsInt)_threads : 1);
+}
+
+void HighsBackend::setTimeLimit( double seconds )
+{
+	Highs_setDoubleOptionValue(highs, "time_limit", seconds > 0 ? seconds : infinity);
+}
+
+// no counterpart in HiGHS
+void HighsBackend::setParallelMode( int mode )
+{
+}
+
+void HighsBackend::setMemoryLimits( double workMemory, double treeMemory )
+{
+}
+
+void HighsBackend::setLogging( bool logging )
+{
+	Highs_setBoolOptionValue(highs, "output_flag", logging ? 1 : 0);
+}
+
+void HighsBackend::setCallback( Callback* callback, int hooks )
+{
+	if (hooks != 0) {
+		cerr << "HiGHS backend has no callbacks\n";
+		exit( -1 );
+	}
+}
+
+int HighsBackend::getSupportedHooks() const
+{
+	return supportedHooks("highs");
+}
+
+// HiGHS keeps a single start, the columns missing in it are 0
+void HighsBackend::addMIPStart( const Expr& solution )
+{
+	start.assign(columns, 0);
+	for (unsigned int i=0; i<solution.columns.size(); i++) {
+		start[ solution.columns[i] ] = solution.values[i];
+	}
+}
+
+void HighsBackend::clearMIPStarts()
+{
+	start.clear();
+}
+
+void HighsBackend::abort()
+{
+	aborted = true;
+}
+
+void HighsBackend::extract()
+{
+}
+
+bool HighsBackend::solve()
+{
+	solved = true;
+	feasible = optimal = false;
+	values.assign(columns, 0);
+	if (aborted) {
+		return false;
+	}
+
+	if (!start.empty()) {
+		Highs_setSolution(highs, &start[0], NULL, NULL, NULL);
+	}
+	Highs_run(highs);
+
+	HighsInt status = Highs_getModelStatus(highs);
+	HighsInt solutionStatus = 0;
+	Highs_getIntInfoValue(highs, "primal_solution_status", &solutionStatus);
+	optimal = (status == kHighsModelStatusOptimal);
+	feasible = (solutionStatus == kHighsSolutionStatusFeasible);
+
+	if (feasible) {
+		vector<double> columnDuals(columns), rowValues(Highs_getNumRow(highs)), rowDuals(rowValues.size());
+		Highs_getSolution(highs, values.empty() ? NULL : &values[0], columnDuals.empty() ? NULL : &columnDuals[0],
+				rowValues.empty() ? NULL : &rowValues[0], rowDuals.empty() ? NULL : &rowDuals[0]);
+	}
+	return feasible;
+}
+
+bool HighsBackend::isOptimal()
+{
+	return optimal;
+}
+
+string HighsBackend::getStatus()
+{
+	if (!solved) {
+		return "not solved";
+	}
+	if (aborted) {
+		return "Aborted";
+	}
+	HighsInt status = Highs_getModelStatus(highs);
+	if (status == kHighsModelStatusOptimal) {
+		return "Optimal";
+	} else if (status == kHighsModelStatusInfeasible) {
+		return "Infeasible";
+	} else if (status == kHighsModelStatusTimeLimit) {
+		return feasible ? "Feasible (time limit)" : "Time limit";
+	}
+	stringstream result;
+	result << "HiGHS model status " << status;
+	return result.str();
+}
+
+double HighsBackend::getObjectiveValue()
+{
+	return feasible ? Highs_getObjectiveValue(highs) : 0;
+}
+
+double HighsBackend::getBestBound()
+{
+	double bound = -INF;
+	if (solved && !aborted) {
+		Highs_getDoubleInfoValue(highs, "mip_dual_bound", &bound);
+	}
+	return bound;
+}
+
+double HighsBackend::getValue( int column )
+{
+	return values[column];
+}
+
+int HighsBackend::getNodes()
+{
+	int64_t nodes = 0;
+	if (solved && !aborted) {
+		Highs_getInt64InfoValue(highs, "mip_node_count", &nodes);
+	}
+	return (int)nodes;
+}
+
+// not reported by HiGHS
+int HighsBackend::getCuts()
+{
+	return 0;
+}
+
+#endif // KMST_HIGHS
@@ -0,0 +1,73 @@
+#ifndef __HIGHS_BACKEND__H__
+#define __HIGHS_BACKEND__H__
+
+#include "MILPBackend.h"
+
+using namespace std;
+
+#ifdef KMST_HIGHS
+
+// MILPBackend on the C interface of HiGHS, which needs no licence (make HIGHS=1)
+//
+// columns and rows are passed to HiGHS as they are added, names are not kept; HiGHS has no
+// callbacks here, so only models without lazy rows run on it and abort only stops the next solve
+class HighsBackend : public MILPBackend
+{
+
+public:
+
+	HighsBackend();
+	~HighsBackend();
+
+	int addColumn( double lb, double ub, double cost, VarType type, string name );
+	void setBounds( int column, double lb, double ub );
+	int addRow( const Expr& expr, double lb, double ub );
+	int addRows( const RowBlock& block );
+	void setRowBounds( int row, double lb, double ub );
+	void setCoefficient( int row, int column, double value );
+
+	void setThreads( u_int _threads );
+	void setTimeLimit( double seconds );
+	void setParallelMode( int mode );
+	void setMemoryLimits( double workMemory, double treeMemory );
+	void setLogging( bool logging );
+
+	void setCallback( Callback* callback, int hooks );
+	int getSupportedHooks() const;
+
+	void addMIPStart( const Expr& start );
+	void clearMIPStarts();
+	void abort();
+	void extract();
+
+	bool solve();
+	bool isOptimal();
+	string getStatus();
+	double getObjectiveValue();
+	double getBestBound();
+	double getValue( int column );
+	int getNodes();
+	int getCuts();
+
+private:
+
+	void* highs;
+	double infinity;
+	int columns, rows;
+
+	volatile bool aborted;
+	bool solved, feasible, optimal;
+	vector<double> values;
+	vector<double> start; // of the next solve, empty if none
+
+	double toHighs( double bound );
+
+	HighsBackend( const HighsBackend& );
+	HighsBackend& operator=( const HighsBackend& );
+
+};
+// HighsBackend
+
+#endif // KMST_HIGHS
+
+#endif //__HIGHS_BACKEND__H__
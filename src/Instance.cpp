@@ -2,38 +2,262 @@
 
 #include "Tools.h"
 
-Instance::Instance( string file )
-{
-	ifstream ifs( file.c_str() );
-	if( ifs.fail() ) {
-		cerr << "could not open input file " << file << "\n";
-		exit( -1 );
-	}
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+static const char BINARY_MAGIC[8] = { 'K', 'M', 'S', 'T', 'B', 'I', 'N', '\0' };
+static const u_int BYTE_ORDER_MARK = 0x01020304;
+static const u_int BINARY_VERSION = 1;
 
+Instance::Instance( string file ) :
+		mapped( NULL ), mappedSize( 0 )
+{
 	cout << "Reading instance from file " << file << "\n";
 
-	ifs >> n_nodes >> n_edges;
+	if( isBinary( file ) ) {
+		mapBinary( file );
+	} else {
+		readText( file );
+	}
+
 	cout << "Number of nodes: " << n_nodes << "\n";
 	cout << "Number of edges: " << n_edges << "\n";
 
-	edges.resize( n_edges );
-	incidentEdges.resize( n_nodes );
-
-	u_int id;
-	while( ifs >> id ) {
-		ifs >> edges[id].v1 >> edges[id].v2 >> edges[id].weight;
-		incidentEdges[edges[id].v1].push_back( id );
-		incidentEdges[edges[id].v2].push_back( id );
-	}
-	ifs.close();
-
 //	cout << "Incidency list:" << "\n";
 //	for( u_int v = 0; v < n_nodes; v++ ) {
 //		cout << v << ": ";
-//		for( list<u_int>::iterator li = incidentEdges[v].begin();
-//				li != incidentEdges[v].end(); li++ ) {
+//		Span incident = incidentEdges( v );
+//		for( const u_int* li = incident.begin(); li != incident.end(); li++ ) {
 //			cout << "(" << edges[*li].v1 << "," << edges[*li].v2 << "), ";
 //		}
 //		cout << "\n";
 //	}
 }
+
+Instance::Instance( u_int _n_nodes, const vector<Edge>& _edges ) :
+		n_nodes( _n_nodes ), n_edges( _edges.size() ), mapped( NULL ), mappedSize( 0 )
+{
+	storage.assign( blockWords( n_nodes, n_edges ), 0 );
+	for( u_int id = 0; id < n_edges; id++ ) {
+		storage[id] = _edges[id].v1;
+		storage[n_edges + id] = _edges[id].v2;
+		storage[2 * n_edges + id] = (u_int)_edges[id].weight;
+	}
+	buildAdjacency();
+}
+
+Instance::~Instance()
+{
+	if( mapped != NULL ) {
+		munmap( mapped, mappedSize );
+	}
+}
+
+void Instance::readText( string file )
+{
+	ifstream ifs( file.c_str(), ios::in | ios::binary );
+	if( ifs.fail() ) {
+		cerr << "could not open input file " << file << "\n";
+		exit( -1 );
+	}
+
+	// whole file at once, tokens are parsed in place
+	ifs.seekg( 0, ios::end );
+	string text( (size_t)ifs.tellg(), '\0' );
+	ifs.seekg( 0, ios::beg );
+	if( !text.empty() ) {
+		ifs.read( &text[0], text.size() );
+	}
+	ifs.close();
+
+	const char* pos = text.c_str();
+	char* end;
+	n_nodes = strtoul( pos, &end, 10 ); pos = end;
+	n_edges = strtoul( pos, &end, 10 ); pos = end;
+
+	storage.assign( blockWords( n_nodes, n_edges ), 0 );
+	while( true ) {
+		u_int id = strtoul( pos, &end, 10 );
+		if( end == pos ) {
+			break;
+		}
+		pos = end;
+		if( id >= n_edges ) {
+			cerr << "invalid edge id " << id << " in input file " << file << "\n";
+			exit( -1 );
+		}
+		storage[id] = strtoul( pos, &end, 10 ); pos = end;
+		storage[n_edges + id] = strtoul( pos, &end, 10 ); pos = end;
+		storage[2 * n_edges + id] = (u_int)strtol( pos, &end, 10 ); pos = end;
+		if( storage[id] >= n_nodes || storage[n_edges + id] >= n_nodes ) {
+			cerr << "invalid vertex of edge " << id << " in input file " << file << "\n";
+			exit( -1 );
+		}
+	}
+
+	buildAdjacency();
+}
+
+bool Instance::isBinary( string file )
+{
+	ifstream ifs( file.c_str(), ios::in | ios::binary );
+	char magic[sizeof( BINARY_MAGIC )];
+	if( !ifs.read( magic, sizeof( magic ) ) ) {
+		return false;
+	}
+	return memcmp( magic, BINARY_MAGIC, sizeof( magic ) ) == 0;
+}
+
+void Instance::mapBinary( string file )
+{
+	int fd = open( file.c_str(), O_RDONLY );
+	struct stat status;
+	if( fd < 0 || fstat( fd, &status ) != 0 ) {
+		cerr << "could not open input file " << file << "\n";
+		exit( -1 );
+	}
+	mappedSize = status.st_size;
+	if( mappedSize < sizeof( BinaryHeader ) ) {
+		cerr << "truncated binary instance " << file << "\n";
+		exit( -1 );
+	}
+	mapped = mmap( NULL, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if( mapped == MAP_FAILED ) {
+		cerr << "could not map input file " << file << "\n";
+		exit( -1 );
+	}
+
+	const BinaryHeader* header = (const BinaryHeader*)mapped;
+	if( header->byteOrder != BYTE_ORDER_MARK || header->version != BINARY_VERSION ) {
+		cerr << "binary instance " << file << " was written by another version or machine, convert it again\n";
+		exit( -1 );
+	}
+	n_nodes = header->n_nodes;
+	n_edges = header->n_edges;
+	if( mappedSize != sizeof( BinaryHeader ) + blockWords( n_nodes, n_edges ) * sizeof( u_int ) ) {
+		cerr << "truncated binary instance " << file << "\n";
+		exit( -1 );
+	}
+
+	attach( (const u_int*)( header + 1 ) );
+	if( !isConsistent() ) {
+		cerr << "corrupt binary instance " << file << ", convert it again\n";
+		exit( -1 );
+	}
+}
+
+// ids of a mapped block are used as indices without further checks, so one linear pass over
+// the block validates them; mapping saves parsing and building the adjacency, not this pass
+bool Instance::isConsistent() const
+{
+	for( u_int id = 0; id < n_edges; id++ ) {
+		if( edges.v1[id] >= n_nodes || edges.v2[id] >= n_nodes ) {
+			return false;
+		}
+	}
+	if( offsets[0] != 0 || offsets[n_nodes] != 2 * n_edges ) {
+		return false;
+	}
+	for( u_int v = 0; v < n_nodes; v++ ) {
+		if( offsets[v] > offsets[v + 1] ) {
+			return false;
+		}
+	}
+	for( u_int i = 0; i < 2 * n_edges; i++ ) {
+		if( incidentIds[i] >= n_edges || neighbourIds[i] >= n_nodes ||
+				outgoingIds[i] >= 2 * n_edges || incomingIds[i] >= 2 * n_edges ) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void Instance::writeBinary( string file ) const
+{
+	ofstream ofs( file.c_str(), ios::out | ios::binary | ios::trunc );
+	if( ofs.fail() ) {
+		cerr << "could not open output file " << file << "\n";
+		exit( -1 );
+	}
+
+	BinaryHeader header;
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, BINARY_MAGIC, sizeof( header.magic ) );
+	header.byteOrder = BYTE_ORDER_MARK;
+	header.version = BINARY_VERSION;
+	header.n_nodes = n_nodes;
+	header.n_edges = n_edges;
+	ofs.write( (const char*)&header, sizeof( header ) );
+
+	// the arrays are consecutive, starting with v1
+	ofs.write( (const char*)edges.v1, blockWords( n_nodes, n_edges ) * sizeof( u_int ) );
+	if( ofs.fail() ) {
+		cerr << "could not write output file " << file << "\n";
+		exit( -1 );
+	}
+}
+
+// v1, v2, weight (n_edges each), offsets (n_nodes + 1), incident edges, neighbours,
+// outgoing and incoming arcs (2 n_edges each)
+size_t Instance::blockWords( u_int n_nodes, u_int n_edges )
+{
+	return 3 * (size_t)n_edges + n_nodes + 1 + 8 * (size_t)n_edges;
+}
+
+void Instance::attach( const u_int* block )
+{
+	edges.v1 = block;
+	edges.v2 = block + n_edges;
+	edges.weight = (const int*)( block + 2 * n_edges );
+	edges.count = n_edges;
+
+	offsets = block + 3 * n_edges;
+	incidentIds = offsets + n_nodes + 1;
+	neighbourIds = incidentIds + 2 * n_edges;
+	outgoingIds = neighbourIds + 2 * n_edges;
+	incomingIds = outgoingIds + 2 * n_edges;
+}
+
+// fills the adjacency part of storage from its edge block
+void Instance::buildAdjacency()
+{
+	attach( &storage[0] );
+	u_int* offsetsOut = &storage[0] + ( offsets - edges.v1 );
+	u_int* incidentOut = &storage[0] + ( incidentIds - edges.v1 );
+	u_int* neighbourOut = &storage[0] + ( neighbourIds - edges.v1 );
+	u_int* outgoingOut = &storage[0] + ( outgoingIds - edges.v1 );
+	u_int* incomingOut = &storage[0] + ( incomingIds - edges.v1 );
+
+	// counting sort of both edge ends by vertex
+	for( u_int v = 0; v <= n_nodes; v++ ) {
+		offsetsOut[v] = 0;
+	}
+	for( u_int id = 0; id < n_edges; id++ ) {
+		offsetsOut[edges.v1[id] + 1]++;
+		offsetsOut[edges.v2[id] + 1]++;
+	}
+	for( u_int v = 0; v < n_nodes; v++ ) {
+		offsetsOut[v + 1] += offsetsOut[v];
+	}
+
+	vector<u_int> next( offsetsOut, offsetsOut + n_nodes );
+	for( u_int id = 0; id < n_edges; id++ ) {
+		u_int v1 = edges.v1[id], v2 = edges.v2[id];
+
+		u_int pos = next[v1]++;
+		incidentOut[pos] = id;
+		neighbourOut[pos] = v2;
+		outgoingOut[pos] = id;
+		incomingOut[pos] = id + n_edges;
+
+		pos = next[v2]++;
+		incidentOut[pos] = id;
+		neighbourOut[pos] = v1;
+		outgoingOut[pos] = id + n_edges;
+		incomingOut[pos] = id;
+	}
+}
@@ -3,7 +3,6 @@
 
 #include <iostream>
 #include <vector>
-#include <list>
 #include <string>
 #include <fstream>
 #include <sys/types.h>
@@ -21,17 +20,116 @@ public:
 		int weight;
 	};
 
+	// read-only view on the edge block, which is stored as struct of arrays
+	struct EdgeArray
+	{
+		const u_int *v1, *v2;
+		const int *weight;
+		u_int count;
+
+		Edge operator[]( u_int id ) const { Edge edge = { v1[id], v2[id], weight[id] }; return edge; }
+		u_int size() const { return count; }
+	};
+
+	// contiguous range of ids in the adjacency arrays, valid as long as the instance
+	struct Span
+	{
+		const u_int *first, *last;
+
+		const u_int* begin() const { return first; }
+		const u_int* end() const { return last; }
+		u_int size() const { return last - first; }
+		bool empty() const { return first == last; }
+		u_int operator[]( u_int i ) const { return first[i]; }
+	};
+
 	// number of nodes and edges
 	u_int n_nodes, n_edges;
 	// array of edges
-	vector<Edge> edges;
-	// incident edges denoted by index in vector <edges>
-	vector<list<u_int> > incidentEdges;
+	EdgeArray edges;
 
-	// constructor
+	// constructor, reads the .dat text format or maps the binary format (detected by its magic)
 	Instance( string file );
+	// build from given edges (e.g. a reduced instance)
+	Instance( u_int _n_nodes, const vector<Edge>& _edges );
+	~Instance();
+
+	// binary format: header, edge block (v1, v2, weight) and the adjacency index below,
+	// all as 32 bit words in native byte order so that it can be used in place
+	// (loading maps it and checks the ids in one pass, linear but without parsing or allocation)
+	void writeBinary( string file ) const;
+	static bool isBinary( string file );
+
+	// incident edges denoted by index in <edges>, neighbours in the same order
+	Span incidentEdges( u_int vertex ) const;
+	Span neighbours( u_int vertex ) const;
+	// directed arcs: edge id for v1->v2, edge id + n_edges for v2->v1
+	Span outgoingArcs( u_int vertex ) const;
+	Span incomingArcs( u_int vertex ) const;
+
+private:
+
+	struct BinaryHeader
+	{
+		char magic[8];
+		u_int byteOrder, version;
+		u_int n_nodes, n_edges;
+		u_int reserved[2];
+	};
+
+	// compressed sparse rows: entries of vertex v at [offsets[v], offsets[v+1])
+	const u_int *offsets;
+	const u_int *incidentIds, *neighbourIds, *outgoingIds, *incomingIds;
+
+	// all arrays in one block, either owned or a mapped file
+	vector<u_int> storage;
+	void *mapped;
+	size_t mappedSize;
+
+	void readText( string file );
+	void mapBinary( string file );
+
+	static size_t blockWords( u_int n_nodes, u_int n_edges );
+	void attach( const u_int* block );
+	bool isConsistent() const; // ids and offsets of the attached block in range
+	void buildAdjacency();
+
+	Span span( const u_int* ids, u_int vertex ) const;
+
+	// views into the storage must not be shared
+	Instance( const Instance& );
+	Instance& operator=( const Instance& );
 
 };
 // Instance
 
+// accessors are inline, model construction calls them in its innermost loops
+inline Instance::Span Instance::span( const u_int* ids, u_int vertex ) const
+{
+	Span result;
+	result.first = ids + offsets[vertex];
+	result.last = ids + offsets[vertex + 1];
+	return result;
+}
+
+inline Instance::Span Instance::incidentEdges( u_int vertex ) const
+{
+	return span( incidentIds, vertex );
+}
+
+inline Instance::Span Instance::neighbours( u_int vertex ) const
+{
+	return span( neighbourIds, vertex );
+}
+
+inline Instance::Span Instance::outgoingArcs( u_int vertex ) const
+{
+	return span( outgoingIds, vertex );
+}
+
+inline Instance::Span Instance::incomingArcs( u_int vertex ) const
+{
+	return span( incomingIds, vertex );
+}
+
 #endif //__INSTANCE__H__
@@ -0,0 +1,138 @@
+#include "KSweep.h"
+
+#include "kMST_ILP.h"
+
+#include <fstream>
+#include <pthread.h>
+
+KSweep::KSweep( Instance& _instance, string _model_type, int _kFrom, int _kTo ) :
+		instance( _instance ), model_type( _model_type ), kFrom( _kFrom ), kTo( _kTo ),
+		segments( 1 ), threads( 1 )
+{
+	if (kFrom < 1 || kTo < kFrom) {
+		cerr << "invalid k range " << kFrom << ":" << kTo << "\n";
+		exit( -1 );
+	}
+	// its vertices and arcs are excluded for one k
+	if (model_type == "mcf-lean") {
+		cerr << "mcf-lean can't change k, a sweep needs another model\n";
+		exit( -1 );
+	}
+}
+
+void KSweep::setSegments( u_int _segments )
+{
+	segments = max(_segments, 1u);
+}
+
+void KSweep::setThreads( u_int _threads )
+{
+	threads = max(_threads, 1u);
+}
+
+const vector<KSweep::Point>& KSweep::getPoints() const
+{
+	return points;
+}
+
+void KSweep::solveSegment( u_int segment )
+{
+	// consecutive k, the first segments get the remainder
+	int count = kTo - kFrom + 1;
+	int first = kFrom + segment * (count / segments) + min((int)segment, count % (int)segments);
+	int last = first + count / segments + ((int)segment < count % (int)segments ? 1 : 0) - 1;
+
+	kMST_ILP ilp( instance, model_type, first );
+	ilp.setThreads( threads );
+
+	// a solver error ends this segment, the others go on
+	try {
+		for (int k=first; k<=last; k++) {
+			double start = Tools::wallTime();
+			ilp.setK( k );
+			ilp.solve();
+
+			Point& point = points[k - kFrom];
+			point.k = k;
+			point.objectiveValue = ilp.getObjectiveValue();
+			point.nodes = ilp.getNodes();
+			point.wallTime = Tools::wallTime() - start;
+			point.solved = true;
+			point.feasible = ilp.getTree().isValid();
+
+			ilp.setWarmStart( ilp.getTree() );
+		}
+	} catch (exception& e) {
+		cerr << "KSweep: segment k=" << first << ".." << last << " failed: " << e.what() << "\n";
+	}
+}
+
+struct SweepWorker
+{
+	KSweep* sweep;
+	u_int segment;
+};
+
+static void* runSweepWorker( void* arg )
+{
+	SweepWorker* worker = (SweepWorker*)arg;
+	worker->sweep->solveSegment(worker->segment);
+	return NULL;
+}
+
+void KSweep::solve()
+{
+	points.assign(kTo - kFrom + 1, Point());
+	u_int used = min(segments, (u_int)(kTo - kFrom + 1));
+	segments = used;
+
+	vector<SweepWorker> workers(used);
+	vector<pthread_t> handles(used);
+	for (u_int i=0; i<used; i++) {
+		workers[i].sweep = this;
+		workers[i].segment = i;
+	}
+
+	// segment 0 runs in the calling thread
+	for (u_int i=1; i<used; i++) {
+		pthread_create(&handles[i], NULL, runSweepWorker, &workers[i]);
+	}
+	runSweepWorker(&workers[0]);
+	for (u_int i=1; i<used; i++) {
+		pthread_join(handles[i], NULL);
+	}
+}
+
+static const string LOG_HEADER = "Filename\tModel\tNodes\tCost\tB&B N\tWallTime\tSegments\tThreads";
+
+void KSweep::writeLog( ostream& out, string file, bool withHeader ) const
+{
+	if (withHeader) {
+		out << LOG_HEADER << "\r\n";
+	}
+	for (unsigned int i=0; i<points.size(); i++) {
+		if (!points[i].solved) {
+			continue;
+		}
+		out << file << "\t" << model_type << "\t" << points[i].k << "\t";
+		if (points[i].feasible) {
+			out << points[i].objectiveValue;
+		} else {
+			out << "-";
+		}
+		out << "\t" << points[i].nodes << "\t" << points[i].wallTime << "\t" << segments << "\t" << threads << "\r\n";
+	}
+}
+
+bool KSweep::isLogFile( string filename )
+{
+	ifstream in( filename.c_str() );
+	string header;
+	if (!getline(in, header)) {
+		return true;
+	}
+	if (!header.empty() && header[header.size() - 1] == '\r') {
+		header.erase(header.size() - 1);
+	}
+	return header == LOG_HEADER;
+}
@@ -0,0 +1,58 @@
+#ifndef __K_SWEEP__H__
+#define __K_SWEEP__H__
+
+#include "Tools.h"
+#include "Instance.h"
+
+using namespace std;
+
+// optimal costs for a range of k
+//
+// the range is split into segments of consecutive k, every segment builds its model once,
+// changes k in place and warm starts from the tree of the previous k; segments run in parallel
+class KSweep
+{
+
+public:
+
+	struct Point
+	{
+		int k;
+		double objectiveValue;
+		int nodes;
+		double wallTime;
+		bool solved; // false if the segment of k failed before it
+		bool feasible; // false if the solve ended without a solution, objectiveValue is 0 then
+	};
+
+	KSweep( Instance& _instance, string _model_type, int _kFrom, int _kTo );
+
+	void setSegments( u_int _segments );
+	void setThreads( u_int _threads ); // per segment
+
+	void solve();
+
+	const vector<Point>& getPoints() const; // ascending k
+
+	// one line per solved k: the columns of the single run log, but wall time instead of CPU time,
+	// which can't be split by k while segments run in parallel, then segments and threads per segment
+	void writeLog( ostream& out, string file, bool withHeader ) const;
+	static bool isLogFile( string filename ); // missing, empty or written by writeLog
+
+	// used by the workers
+	void solveSegment( u_int segment );
+
+private:
+
+	Instance& instance;
+	string model_type;
+	int kFrom, kTo;
+
+	u_int segments, threads;
+
+	vector<Point> points;
+
+};
+// KSweep
+
+#endif //__K_SWEEP__H__
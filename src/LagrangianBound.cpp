@@ -0,0 +1,275 @@
+#include "LagrangianBound.h"
+
+#include "Tools.h"
+
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+LagrangianBound::LagrangianBound( const Instance& _instance, int _k ) :
+		instance( _instance ), k( _k ), iterationLimit( 300 ), threads( Tools::availableCores() ),
+		alpha( _instance.n_nodes, 0 ), gamma1( _instance.n_edges, 0 ), gamma2( _instance.n_edges, 0 ),
+		xSelected( _instance.n_edges, false ), ySelected( _instance.n_nodes, false ),
+		edgeCost( _instance.n_edges, 0 ), vertexCost( _instance.n_nodes, 0 ),
+		lastEdgeCost( 0 ), lastVertexCost( 0 ), lowerBound( 0 ), upperBound( INT_MAX ), iterations( 0 ),
+		bestLastEdgeCost( 0 ), bestLastVertexCost( 0 )
+{
+}
+
+void LagrangianBound::setIterationLimit( int limit )
+{
+	iterationLimit = limit;
+}
+
+void LagrangianBound::setThreads( u_int _threads )
+{
+	threads = max(_threads, 1u);
+}
+
+bool LagrangianBound::isRealEdge( u_int edge ) const
+{
+	return instance.edges[edge].v1 != 0 && instance.edges[edge].v2 != 0;
+}
+
+// solve the relaxation for the current multipliers, returns its value
+double LagrangianBound::evaluate()
+{
+	const u_int n = instance.n_nodes, m = instance.n_edges;
+
+	for (u_int v=0; v<n; v++) {
+		vertexCost[v] = alpha[v];
+	}
+	vector<pair<double, u_int> > sortedEdges;
+	sortedEdges.reserve(m);
+	for (u_int e=0; e<m; e++) {
+		xSelected[e] = false;
+		if (!isRealEdge(e)) {
+			continue;
+		}
+		const Instance::Edge & edge = instance.edges[e];
+		edgeCost[e] = edge.weight - alpha[edge.v1] - alpha[edge.v2] + gamma1[e] + gamma2[e];
+		vertexCost[edge.v1] -= gamma1[e];
+		vertexCost[edge.v2] -= gamma2[e];
+		sortedEdges.push_back(pair<double, u_int>(edgeCost[e], e));
+	}
+	sort(sortedEdges.begin(), sortedEdges.end());
+
+	double value = 0;
+
+	// forest of the k-1 cheapest edges (greedy is optimal on the truncated graphic matroid)
+	vector<u_int> parent(n);
+	for (u_int v=0; v<n; v++) {
+		parent[v] = v;
+	}
+	int taken = 0;
+	for (unsigned int i=0; i<sortedEdges.size() && taken < k-1; i++) {
+		u_int a = instance.edges[ sortedEdges[i].second ].v1, b = instance.edges[ sortedEdges[i].second ].v2;
+		while (parent[a] != a) a = parent[a] = parent[ parent[a] ];
+		while (parent[b] != b) b = parent[b] = parent[ parent[b] ];
+		if (a == b) {
+			continue;
+		}
+		parent[a] = b;
+		xSelected[ sortedEdges[i].second ] = true;
+		value += sortedEdges[i].first;
+		lastEdgeCost = sortedEdges[i].first;
+		taken++;
+	}
+	if (taken < k-1) {
+		return HUGE_VAL; // no forest with k-1 edges, so no k-tree either
+	}
+
+	// k cheapest vertices, 0 is the artificial root
+	vector<pair<double, u_int> > sortedVertices;
+	for (u_int v=1; v<n; v++) {
+		ySelected[v] = false;
+		sortedVertices.push_back(pair<double, u_int>(vertexCost[v], v));
+	}
+	if ((int)sortedVertices.size() < k) {
+		return HUGE_VAL;
+	}
+	partial_sort(sortedVertices.begin(), sortedVertices.begin() + k, sortedVertices.end());
+	for (int i=0; i<k; i++) {
+		ySelected[ sortedVertices[i].second ] = true;
+		value += sortedVertices[i].first;
+	}
+	lastVertexCost = sortedVertices[k-1].first;
+
+	return value;
+}
+
+void LagrangianBound::solve( int knownUpperBound )
+{
+	const u_int n = instance.n_nodes, m = instance.n_edges;
+
+	KTreeHeuristic heuristic(instance, k);
+	tree = heuristic.solve(threads);
+	upperBound = tree.weight;
+	if (knownUpperBound >= 0 && knownUpperBound < upperBound) {
+		upperBound = knownUpperBound;
+	}
+
+	lowerBound = -HUGE_VAL;
+	double stepFactor = 2;
+	int sinceImprovement = 0;
+
+	for (iterations=0; iterations<iterationLimit; iterations++) {
+		double value = evaluate();
+		if (value == HUGE_VAL) {
+			lowerBound = value; // infeasible
+			break;
+		}
+
+		if (value > lowerBound + 1e-9) {
+			lowerBound = value;
+			bestEdgeCost = edgeCost;
+			bestAlpha = alpha;
+			bestGamma1 = gamma1;
+			bestGamma2 = gamma2;
+			bestVertexCost = vertexCost;
+			bestLastEdgeCost = lastEdgeCost;
+			bestLastVertexCost = lastVertexCost;
+			sinceImprovement = 0;
+		} else if (++sinceImprovement >= 20) {
+			stepFactor /= 2;
+			sinceImprovement = 0;
+		}
+
+		// lagrangian heuristic: spanning tree on the selected vertices
+		if (iterations % 10 == 0 || sinceImprovement == 0) {
+			vector<u_int> selected;
+			for (u_int v=1; v<n; v++) {
+				if (ySelected[v]) {
+					selected.push_back(v);
+				}
+			}
+			KTree candidate = heuristic.spanningTree(selected);
+			heuristic.improve(candidate);
+			if (candidate.weight < tree.weight) {
+				tree = candidate;
+				upperBound = min(upperBound, tree.weight);
+			}
+		}
+
+		// integral weights: bound can't be improved any further
+		if (ceil(lowerBound - 1e-6) >= upperBound || stepFactor < 1e-4) {
+			break;
+		}
+
+		// subgradients of the dualized constraints y_v - x(delta(v)) <= 0, x_e - y_u <= 0
+		vector<double> alphaGradient(n, 0), gamma1Gradient(m, 0), gamma2Gradient(m, 0);
+		for (u_int v=1; v<n; v++) {
+			alphaGradient[v] = ySelected[v] ? 1 : 0;
+		}
+		for (u_int e=0; e<m; e++) {
+			if (!isRealEdge(e)) {
+				continue;
+			}
+			const Instance::Edge & edge = instance.edges[e];
+			int x = xSelected[e] ? 1 : 0;
+			alphaGradient[edge.v1] -= x;
+			alphaGradient[edge.v2] -= x;
+			gamma1Gradient[e] = x - (ySelected[edge.v1] ? 1 : 0);
+			gamma2Gradient[e] = x - (ySelected[edge.v2] ? 1 : 0);
+		}
+
+		// only components which can move count for the step length
+		double norm = 0;
+		for (u_int v=1; v<n; v++) {
+			if (alpha[v] > 0 || alphaGradient[v] > 0) norm += alphaGradient[v] * alphaGradient[v];
+		}
+		for (u_int e=0; e<m; e++) {
+			if (gamma1[e] > 0 || gamma1Gradient[e] > 0) norm += gamma1Gradient[e] * gamma1Gradient[e];
+			if (gamma2[e] > 0 || gamma2Gradient[e] > 0) norm += gamma2Gradient[e] * gamma2Gradient[e];
+		}
+		if (norm == 0) {
+			break; // relaxed solution is a k-tree
+		}
+
+		double step = stepFactor * (upperBound - value) / norm;
+		for (u_int v=1; v<n; v++) {
+			alpha[v] = max(0.0, alpha[v] + step * alphaGradient[v]);
+		}
+		for (u_int e=0; e<m; e++) {
+			gamma1[e] = max(0.0, gamma1[e] + step * gamma1Gradient[e]);
+			gamma2[e] = max(0.0, gamma2[e] + step * gamma2Gradient[e]);
+		}
+	}
+}
+
+double LagrangianBound::getLowerBound() const
+{
+	return lowerBound;
+}
+
+int LagrangianBound::getUpperBound() const
+{
+	return upperBound;
+}
+
+const KTree& LagrangianBound::getTree() const
+{
+	return tree;
+}
+
+int LagrangianBound::getIterations() const
+{
+	return iterations;
+}
+
+void LagrangianBound::getMultipliers( vector<double>& _alpha, vector<double>& _gamma1,
+		vector<double>& _gamma2 ) const
+{
+	_alpha = bestAlpha;
+	_gamma1 = bestGamma1;
+	_gamma2 = bestGamma2;
+}
+
+void LagrangianBound::getExclusions( double bound, vector<bool>& excludedEdges,
+		vector<bool>& excludedVertices ) const
+{
+	excludedEdges.assign(instance.n_edges, false);
+	excludedVertices.assign(instance.n_nodes, false);
+	if (bestEdgeCost.empty() || lowerBound == HUGE_VAL) {
+		return;
+	}
+
+	// forcing a vertex in replaces the most expensive selected one, for edges likewise
+	for (u_int v=1; v<instance.n_nodes; v++) {
+		if (lowerBound + bestVertexCost[v] - bestLastVertexCost > bound + 1e-6) {
+			excludedVertices[v] = true;
+		}
+	}
+	for (u_int e=0; e<instance.n_edges; e++) {
+		const Instance::Edge & edge = instance.edges[e];
+		if (excludedVertices[edge.v1] || excludedVertices[edge.v2]) {
+			excludedEdges[e] = true;
+		} else if (isRealEdge(e) && lowerBound + bestEdgeCost[e] - bestLastEdgeCost > bound + 1e-6) {
+			excludedEdges[e] = true;
+		}
+	}
+}
+
+void LagrangianBound::getEdgeBounds( vector<double>& bounds ) const
+{
+	bounds.assign(instance.n_edges, -HUGE_VAL);
+	if (bestEdgeCost.empty() || lowerBound == HUGE_VAL) {
+		return;
+	}
+
+	// the edge forces its vertices in and replaces the most expensive selected edge, as in getExclusions
+	for (u_int e=0; e<instance.n_edges; e++) {
+		const Instance::Edge & edge = instance.edges[e];
+		double bound = lowerBound;
+		if (edge.v1 != 0) {
+			bound = max(bound, lowerBound + bestVertexCost[edge.v1] - bestLastVertexCost);
+		}
+		if (edge.v2 != 0) {
+			bound = max(bound, lowerBound + bestVertexCost[edge.v2] - bestLastVertexCost);
+		}
+		if (isRealEdge(e)) {
+			bound = max(bound, lowerBound + bestEdgeCost[e] - bestLastEdgeCost);
+		}
+		bounds[e] = bound;
+	}
+}
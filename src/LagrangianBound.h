@@ -0,0 +1,76 @@
+#ifndef __LAGRANGIAN_BOUND__H__
+#define __LAGRANGIAN_BOUND__H__
+
+#include "Instance.h"
+#include "Heuristic.h"
+
+#include <vector>
+
+using namespace std;
+
+// lower bound for the k-MST by Lagrangian relaxation and subgradient optimization
+//
+// the relaxed problem keeps k vertices and a forest of k-1 real edges, both solved greedily,
+// the linking constraints x(delta(v)) >= y_v and x_e <= y_u, x_e <= y_v are dualized
+class LagrangianBound
+{
+
+public:
+
+	LagrangianBound( const Instance& _instance, int _k );
+
+	void setIterationLimit( int limit );
+	void setThreads( u_int _threads ); // of the start heuristic
+
+	// starts from the construction heuristic if no better upper bound is known
+	void solve( int knownUpperBound = -1 );
+
+	double getLowerBound() const;
+	int getUpperBound() const;
+	const KTree& getTree() const; // best tree found, may be worse than a known upper bound
+	int getIterations() const;
+
+	// multipliers of the best lower bound, empty if there is none (e.g. infeasible)
+	void getMultipliers( vector<double>& _alpha, vector<double>& _gamma1, vector<double>& _gamma2 ) const;
+
+	// edges and vertices that can't be part of any solution of cost <= bound,
+	// derived from the reduced costs of the best multipliers
+	void getExclusions( double bound, vector<bool>& excludedEdges,
+			vector<bool>& excludedVertices ) const;
+
+	// per edge a lower bound on every solution containing it (reduced cost pricing),
+	// -HUGE_VAL if there are no multipliers
+	void getEdgeBounds( vector<double>& bounds ) const;
+
+private:
+
+	const Instance& instance;
+	int k;
+	int iterationLimit;
+	u_int threads;
+
+	// multipliers: alpha per vertex, gamma per edge end (v1, v2)
+	vector<double> alpha, gamma1, gamma2;
+
+	// relaxed solution for the current multipliers
+	vector<bool> xSelected, ySelected;
+	vector<double> edgeCost, vertexCost;
+	double lastEdgeCost, lastVertexCost; // most expensive selected ones
+
+	double lowerBound;
+	int upperBound;
+	KTree tree;
+	int iterations;
+
+	// state of the best lower bound for the exclusions
+	vector<double> bestEdgeCost, bestVertexCost;
+	vector<double> bestAlpha, bestGamma1, bestGamma2;
+	double bestLastEdgeCost, bestLastVertexCost;
+
+	double evaluate();
+	bool isRealEdge( u_int edge ) const;
+
+};
+// LagrangianBound
+
+#endif //__LAGRANGIAN_BOUND__H__
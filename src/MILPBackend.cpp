@@ -0,0 +1,51 @@
+#include "MILPBackend.h"
+
+#include "CplexBackend.h"
+#include "HighsBackend.h"
+
+const double MILPBackend::INF = 1e20;
+
+MILPBackend* MILPBackend::create( string name )
+{
+#ifdef KMST_CPLEX
+	if (name == "cplex") {
+		return new CplexBackend();
+	}
+#else
+	if (name == "cplex") {
+		throw runtime_error("CPLEX backend not compiled in, build with make CPLEX=1");
+	}
+#endif
+#ifdef KMST_HIGHS
+	if (name == "highs") {
+		return new HighsBackend();
+	}
+#else
+	if (name == "highs") {
+		throw runtime_error("HiGHS backend not compiled in, build with make HIGHS=1");
+	}
+#endif
+	if (name.empty()) {
+		throw runtime_error("no MILP backend compiled in, build with make CPLEX=1 or HIGHS=1");
+	}
+	throw runtime_error("unknown backend " + name);
+}
+
+string MILPBackend::defaultName()
+{
+#if defined(KMST_CPLEX)
+	return "cplex";
+#elif defined(KMST_HIGHS)
+	return "highs";
+#else
+	return "";
+#endif
+}
+
+int MILPBackend::supportedHooks( string name )
+{
+	if (name == "cplex") {
+		return LAZY | USER_CUTS | HEURISTIC | BRANCH | PROGRESS | INCUMBENT;
+	}
+	return 0;
+}
@@ -0,0 +1,152 @@
+#ifndef __MILP_BACKEND__H__
+#define __MILP_BACKEND__H__
+
+#include "Tools.h"
+
+using namespace std;
+
+// solver interface of kMST_ILP, columns and rows are added by index
+//
+// implemented for CPLEX (CplexBackend, make CPLEX=1, the default) and HiGHS (HighsBackend,
+// make HIGHS=1); the callback hooks (lazy rows, cuts, heuristics, branching) are CPLEX only
+class MILPBackend
+{
+
+public:
+
+	enum VarType { CONTINUOUS, INTEGER, BINARY };
+
+	// values as IloCplex::ParallelModeType of CPLEX
+	enum ParallelMode { OPPORTUNISTIC = -1, AUTO_PARALLEL = 0, DETERMINISTIC = 1 };
+
+	// hooks of a Callback, combined with |
+	enum Hook { LAZY = 1, USER_CUTS = 2, HEURISTIC = 4, BRANCH = 8, PROGRESS = 16, INCUMBENT = 32 };
+
+	// sparse linear expression over column indices, also column values of a (partial) solution
+	struct Expr
+	{
+		vector<int> columns;
+		vector<double> values;
+		void add( int column, double value ) { columns.push_back(column); values.push_back(value); }
+		void clear() { columns.clear(); values.clear(); }
+	};
+
+	// lb <= expr <= ub, rows added by a callback
+	struct Row
+	{
+		Expr expr;
+		double lb, ub;
+	};
+
+	// rows in compressed form
+	struct RowBlock
+	{
+		vector<int> begin; // first entry per row, one more for the end of the last row
+		vector<int> columns;
+		vector<double> values;
+		vector<double> lb, ub;
+	};
+
+	// state of the search, for the progress hook
+	struct Progress
+	{
+		int nodes;
+		bool feasible; // incumbent only valid if true
+		double incumbent, bound;
+		int cuts; // generated by the solver itself
+	};
+
+	// node of the search tree a heuristic or branch hook is called for
+	class Node
+	{
+	public:
+		virtual ~Node() {}
+		virtual int getNodes() const = 0; // processed so far
+		virtual bool hasIncumbent() const = 0;
+		virtual double getIncumbent() const = 0;
+		virtual double getValue( int column ) const = 0; // in the LP of the node
+		virtual double getUpperBound( int column ) const = 0; // local to the node
+	};
+
+	// the solver's branches are kept unless branchOn is called
+	class BranchNode : public Node
+	{
+	public:
+		// holds in every child, children which raise a fixed column are left out
+		virtual void fixToZero( int column ) = 0;
+		// a down and an up child on this column instead of the solver's branches
+		virtual void branchOn( int column ) = 0;
+	};
+
+	// called during the solve, possibly from several threads at once
+	class Callback
+	{
+	public:
+		virtual ~Callback() {}
+
+		// values of all columns, integral for the lazy rows, the rows they violate are added to rows
+		virtual void separateLazy( const vector<double>& values, vector<Row>& rows ) {}
+		virtual void separateCuts( const vector<double>& values, vector<Row>& rows ) {}
+		// true if solution holds the columns of a solution to try
+		virtual bool findSolution( const Node& node, Expr& solution, double& objective ) { return false; }
+		virtual void branch( BranchNode& node ) {}
+		virtual void progress( const Progress& state ) {}
+		// every improved incumbent, values of all columns
+		virtual void incumbent( const vector<double>& values, double objective ) {}
+	};
+
+	static const double INF; // bound for unbounded sides of columns and rows
+
+	virtual ~MILPBackend() {}
+
+	// returns the index of the new column, an empty name leaves it unnamed
+	virtual int addColumn( double lb, double ub, double cost, VarType type, string name ) = 0;
+	virtual void setBounds( int column, double lb, double ub ) = 0;
+
+	// lb <= expr <= ub, the expression may contain a column several times, returns the row index
+	virtual int addRow( const Expr& expr, double lb, double ub ) = 0;
+	virtual int addRows( const RowBlock& rows ) = 0; // returns the index of the first row
+	virtual void setRowBounds( int row, double lb, double ub ) = 0;
+	virtual void setCoefficient( int row, int column, double value ) = 0;
+
+	virtual void setThreads( u_int threads ) = 0; // 0: single threaded
+	virtual void setTimeLimit( double seconds ) = 0; // wall clock, <= 0: none
+	virtual void setParallelMode( int mode ) = 0;
+	virtual void setMemoryLimits( double workMemory, double treeMemory ) = 0; // MB, 0: defaults
+	virtual void setLogging( bool logging ) = 0; // off by default
+
+	// hooks must be supported, the callback is kept by the caller
+	virtual void setCallback( Callback* callback, int hooks ) = 0;
+	virtual int getSupportedHooks() const = 0;
+
+	// kept until clearMIPStarts
+	virtual void addMIPStart( const Expr& start ) = 0;
+	virtual void clearMIPStarts() = 0;
+
+	// stops a running or the next solve, may be called from another thread
+	virtual void abort() = 0;
+
+	// passes the model to the solver, done by the first solve otherwise; errors of the solver are
+	// thrown as runtime_error by both
+	virtual void extract() = 0;
+
+	// true if a feasible solution was found, optimality is reported by isOptimal
+	virtual bool solve() = 0;
+	virtual bool isOptimal() = 0;
+	virtual string getStatus() = 0; // of the last solve
+	virtual double getObjectiveValue() = 0;
+	virtual double getBestBound() = 0;
+	virtual double getValue( int column ) = 0;
+	virtual int getNodes() = 0;
+	virtual int getCuts() = 0; // generated by the solver itself
+
+	// cplex or highs, throws runtime_error if the backend is unknown or not compiled in
+	static MILPBackend* create( string name );
+	// cplex if compiled in, otherwise highs, empty without any backend
+	static string defaultName();
+	static int supportedHooks( string name ); // 0 for unknown backends
+
+};
+// MILPBackend
+
+#endif //__MILP_BACKEND__H__
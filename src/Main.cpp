@@ -3,19 +3,96 @@
 
 #include <iostream>
 #include <fstream>
+#include <getopt.h>
 #include "Tools.h"
 #include "Instance.h"
 #include "kMST_ILP.h"
+#include "kMST_VNS.h"
+#include "LagrangianBound.h"
+#include "Preprocessor.h"
+#include "Batch.h"
+#include "KSweep.h"
+#include "Portfolio.h"
+#include "kMST_BnB.h"
+#include "ResultCache.h"
+#include "SparseSolver.h"
 
 using namespace std;
 
 void usage()
 {
-	cout << "USAGE:\t<program> -f filename -m model [-k <nodes to connect> -l <logfile>]\n";
-	cout << "EXAMPLE:\t" << "./kmst -f data/g01.dat -m scf -k 5 -l log.txt\n\n";
+	cout << "USAGE:\t<program> -f filename -m model [-k <nodes to connect> -l <logfile> -r <rounds> -t <seconds> -L -p -c <threads> -T <file>]\n";
+	cout << "\t<program> -f filename -m model --k-range <from>:<to> [-j <segments> -c <threads per segment> -l <result file>]\n";
+	cout << "\t<program> -b manifest [-j <concurrent jobs> -c <threads per job> -l <result file> -t <seconds>]\n";
+	cout << "MODELS:\tscf, mcf, mtz, dcc, gsec (CPLEX), vns (heuristic, runs -t seconds),\n";
+	cout << "\tlagrange (lower and upper bound only), portfolio (races the models of --portfolio <list>,\n";
+	cout << "\t\tdefault scf,mtz,dcc, also for -b, in parallel with shared incumbents, -c threads each,\n";
+	cout << "\t\t-t limits its wall clock time),\n";
+	cout << "\tbnb (branch-and-bound without CPLEX, also in builds with make CPLEX=0, -c threads, default all cores,\n";
+	cout << "\t\t-t limits its wall clock time),\n";
+	cout << "\tscf-root, mtz-root (scf and mtz with vertex variables, the root is the smallest selected vertex),\n";
+	cout << "\tmcf-lean (mcf with commodities only for vertices left by Lagrangian reduced costs, continuous flows,\n";
+	cout << "\t\tflow <= edge separated in callbacks)\n";
+	cout << "\t-t <seconds> limits the wall clock time, default 10 for vns and none for the exact models,\n";
+	cout << "\t\truns of exact models that hit it unproven are logged with the note limit\n";
+	cout << "\t-L fixes variables of CPLEX models by Lagrangian reduced costs\n";
+	cout << "\t--node-fixing fixes them against the incumbent at the nodes of the CPLEX tree (counted in -T)\n";
+	cout << "\t--vertex-branching branches on the most fractional vertex of the tree while there is one\n";
+	cout << "\t--lp-repair <nodes>[:<seconds>] repairs the LP point of every x-th node to a k-tree as incumbent,\n";
+	cout << "\t\tat most the given seconds per solve\n";
+	cout << "\t-f takes the .dat text format or binary instances written by kmst-convert\n";
+	cout << "\t-p reduces the graph (reduced cost, shortest path and component tests) before solving\n";
+	cout << "\t--k-range (-K) solves every k of the range with one model per segment (CPLEX models but mcf-lean),\n";
+	cout << "\t\t-l takes a result file of its own (wall time, segments and threads per k)\n";
+	cout << "\t-b runs the jobs of a manifest, lines <file> <model> <k> [<rounds>], -l takes a result file of its own\n";
+	cout << "\t\t(wall time, threads and status per job), failed jobs don't stop the others\n";
+	cout << "\t-c <threads> for CPLEX (default 1), --parallel deterministic|opportunistic|auto (default deterministic),\n";
+	cout << "\t\t--work-mem <MB> and --tree-limit <MB> limit the memory of CPLEX, --names names the variables\n";
+	cout << "\t--backend cplex|highs solves the models on CPLEX (default, make CPLEX=1) or HiGHS (make HIGHS=1),\n";
+	cout << "\t\thighs needs no licence but has no callbacks, so no dcc, gsec or mcf-lean\n";
+	cout << "\t--sparse <d> solves scf, mcf, mtz, dcc or gsec on the d cheapest edges per vertex and the heuristic tree,\n";
+	cout << "\t\tedges whose Lagrangian reduced cost may improve the result are priced in until it is optimal,\n";
+	cout << "\t\t-t limits the wall clock time of all rounds\n";
+	cout << "\t--cache <dir> stores results of exact models by instance content, model and k, proven optimal\n";
+	cout << "\t\tones are returned without solving, others are MIP starts of the next solve (also with -b)\n";
+	cout << "\t-T <file> writes incumbent, bound, gap, nodes, cuts and memory of every CPLEX solve over time,\n";
+	cout << "\t\tsampled on improvements and every -i <seconds> (default 1), --target <cost> adds the time to target\n";
+	cout << "EXAMPLE:\t" << "./kmst -f data/g01.dat -m scf -k 5 -l log.txt\n";
+	cout << "\t\t" << "./kmst -b test.jobs -j 4 -c 2 -l batch.txt\n\n";
 	exit( 1 );
 } // usage
 
+// one line per run, the header is written with the first one, runs without a solution have no cost,
+// unproven ones of exact models get the note limit behind the columns (no baseline for kmst-bench)
+static void appendLog( string logFilename, string file, string model_type, int k, bool solved, bool limited,
+		double objectiveValue, int nodes, double cpuTime )
+{
+	bool exists = false;
+	ifstream logIn(logFilename.c_str());
+	if (logIn) {
+		exists = true;
+	}
+	logIn.close();
+
+	ofstream log;
+	log.open(logFilename.c_str(),ios::ate | ios::app);
+	if (!exists) {
+		log <<"Filename\tModel\tNodes\tCost\tB&B N\tCPUTime\r\n";
+	}
+	log <<file <<"\t"<< model_type <<"\t"<< k <<"\t";
+	if (solved) {
+		log << objectiveValue;
+	} else {
+		log << "-";
+	}
+	log <<"\t"<< nodes <<"\t"<< cpuTime;
+	if (limited) {
+		log << "\tlimit";
+	}
+	log <<"\r\n";
+	log.close();
+}
+
 int main( int argc, char *argv[] )
 {
 	// read parameters
@@ -27,7 +104,45 @@ int main( int argc, char *argv[] )
 	bool doLogging = false;
 	string logFilename("");
 	int rounds = 1;
-	while( (opt = getopt( argc, argv, "f:m:k:l:r:" )) != EOF) {
+	double timeLimit = -1; // not given
+	bool lagrangianFixing = false;
+	bool preprocessing = false;
+	string manifest("");
+	u_int concurrency = 0;
+	u_int threads = 0;
+	int parallelMode = MILPBackend::DETERMINISTIC;
+	double workMemory = 0, treeMemory = 0;
+	string portfolioModels("scf,mtz,dcc");
+	string backend("");
+	string cacheDirectory("");
+	u_int sparseNeighbours = 0;
+	bool variableNames = false;
+	bool nodeFixing = false;
+	bool vertexBranching = false;
+	int repairFrequency = 0;
+	double repairBudget = 0;
+	int kFrom = 0, kTo = 0;
+	string progressFilename("");
+	double progressInterval = 1;
+	bool hasTarget = false;
+	double target = 0;
+	static struct option longOptions[] = {
+		{ "k-range", required_argument, NULL, 'K' },
+		{ "target", required_argument, NULL, 'g' },
+		{ "parallel", required_argument, NULL, 'P' },
+		{ "work-mem", required_argument, NULL, 'W' },
+		{ "tree-limit", required_argument, NULL, 'M' },
+		{ "portfolio", required_argument, NULL, 'F' },
+		{ "backend", required_argument, NULL, 'X' },
+		{ "cache", required_argument, NULL, 'C' },
+		{ "sparse", required_argument, NULL, 'S' },
+		{ "names", no_argument, NULL, 'N' },
+		{ "node-fixing", no_argument, NULL, 'R' },
+		{ "vertex-branching", no_argument, NULL, 'V' },
+		{ "lp-repair", required_argument, NULL, 'H' },
+		{ NULL, 0, NULL, 0 }
+	};
+	while( (opt = getopt_long( argc, argv, "f:m:k:l:r:t:Lpb:j:c:K:T:i:g:", longOptions, NULL )) != EOF) {
 		switch( opt ) {
 			case 'f': // instance file
 				file = optarg;
@@ -45,44 +160,342 @@ int main( int argc, char *argv[] )
 			case 'r': // rounds of executions
 				rounds = atoi( optarg );
 				break;	
+			case 't': // wall clock limit
+				timeLimit = atof( optarg );
+				break;
+			case 'L': // reduced cost fixing
+				lagrangianFixing = true;
+				break;
+			case 'p': // graph reduction
+				preprocessing = true;
+				break;
+			case 'b': // batch of jobs
+				manifest = optarg;
+				break;
+			case 'j': // concurrent jobs of a batch
+				concurrency = atoi( optarg );
+				break;
+			case 'c': // CPLEX threads, per job of a batch or segment of a sweep
+				threads = atoi( optarg );
+				break;
+			case 'K': // range of k, <from>:<to>
+				if (sscanf( optarg, "%d:%d", &kFrom, &kTo ) != 2) {
+					usage();
+				}
+				break;
+			case 'T': // progress time series
+				progressFilename = optarg;
+				break;
+			case 'i': // progress sampling interval
+				progressInterval = atof( optarg );
+				break;
+			case 'g': // objective value for the time to target
+				hasTarget = true;
+				target = atof( optarg );
+				break;
+			case 'P': // deterministic, opportunistic or auto
+				parallelMode = kMST_ILP::parseParallelMode( optarg );
+				break;
+			case 'W': // CPLEX working memory in MB
+				workMemory = atof( optarg );
+				break;
+			case 'M': // branch-and-bound tree limit in MB
+				treeMemory = atof( optarg );
+				break;
+			case 'F': // models of the portfolio
+				portfolioModels = optarg;
+				break;
+			case 'X': // solver behind the compact models
+				backend = optarg;
+				break;
+			case 'C': // directory of the result cache
+				cacheDirectory = optarg;
+				break;
+			case 'S': // cheapest edges per vertex of the sparse core
+				sparseNeighbours = max(atoi( optarg ), 1);
+				break;
+			case 'N': // named CPLEX variables
+				variableNames = true;
+				break;
+			case 'R': // reduced cost fixing in the tree
+				nodeFixing = true;
+				break;
+			case 'V': // branch on vertices first
+				vertexBranching = true;
+				break;
+			case 'H': // lp repair heuristic, <nodes>[:<seconds>]
+				if (sscanf( optarg, "%d:%lf", &repairFrequency, &repairBudget ) < 1 || repairFrequency < 1) {
+					usage();
+				}
+				break;
 			default:
 				usage();
 				break;
 		}
 	}
+	// mcf-lean is built for a single k
+	if (kTo > 0 && model_type == "mcf-lean") {
+		cerr << "mcf-lean can't change k, --k-range needs another model\n";
+		exit( -1 );
+	}
+
+	if (!manifest.empty()) {
+		BatchRunner batch;
+		batch.readManifest( manifest );
+		batch.setThreadsPerJob( threads );
+		// by default the jobs fill the machine
+		batch.setConcurrency( concurrency > 0 ? concurrency : Tools::availableCores() / max(threads, 1u) );
+		batch.setTimeLimit( timeLimit );
+		batch.setPortfolioModels( Portfolio::parseModels( portfolioModels ) );
+		batch.setBackend( backend );
+		if (!cacheDirectory.empty()) {
+			batch.setCache( cacheDirectory );
+		}
+		// the columns differ from those of single runs
+		if (doLogging && !BatchRunner::isLogFile( logFilename )) {
+			cerr << logFilename << " was not written by a batch, batch results need a file of their own\n";
+			exit( -1 );
+		}
+		batch.run();
+
+		if (doLogging) {
+			ifstream logIn(logFilename.c_str());
+			bool exists = logIn.good();
+			logIn.close();
+
+			ofstream log(logFilename.c_str(), ios::ate | ios::app);
+			batch.writeLog(log, !exists);
+			log.close();
+		} else {
+			batch.writeLog(cout, true);
+		}
+		return 0;
+	}
+
+	// cut models and mcf-lean separate rows in callbacks
+	if (model_type != "vns" && model_type != "bnb" && model_type != "lagrange" && model_type != "portfolio" &&
+			!kMST_ILP::isSupported( model_type, backend )) {
+		cerr << "model " << model_type << " needs the callbacks of CPLEX (make CPLEX=1, --backend cplex)\n";
+		exit( -1 );
+	}
+
+	if (kTo > 0) {
+		// reductions depend on k, so the sweep works on the original instance
+		Instance instance( file );
+		KSweep sweep( instance, model_type, kFrom, kTo );
+		sweep.setSegments( concurrency > 0 ? concurrency : 1 );
+		sweep.setThreads( threads );
+		// the columns differ from those of single runs
+		if (doLogging && !KSweep::isLogFile( logFilename )) {
+			cerr << logFilename << " was not written by a sweep, sweep results need a file of their own\n";
+			exit( -1 );
+		}
+		sweep.solve();
+
+		const vector<KSweep::Point>& points = sweep.getPoints();
+		cout << "k\tCost\tB&B N\tWallTime\n";
+		for (unsigned int i=0; i<points.size(); i++) {
+			if (!points[i].solved) {
+				continue;
+			}
+			cout << points[i].k << "\t";
+			if (points[i].feasible) {
+				cout << points[i].objectiveValue;
+			} else {
+				cout << "-";
+			}
+			cout << "\t" << points[i].nodes
+					<< "\t" << points[i].wallTime << "\n";
+		}
+
+		if (doLogging) {
+			ifstream logIn(logFilename.c_str());
+			bool exists = logIn.good();
+			logIn.close();
+
+			ofstream log(logFilename.c_str(), ios::ate | ios::app);
+			sweep.writeLog(log, file, !exists);
+			log.close();
+		}
+		return 0;
+	}
+
+	// exact results are looked up before the instance is read, proven optimal ones are final
+	ResultCache* cache = NULL;
+	string instanceHash, cacheParams = backend.empty() ? "" : "backend=" + backend;
+	ResultCache::Entry cached;
+	bool hasCached = false;
+	if (!cacheDirectory.empty() && model_type != "vns" && model_type != "lagrange") {
+		cache = new ResultCache( cacheDirectory );
+		instanceHash = ResultCache::hashFile( file );
+		hasCached = cache->lookup( instanceHash, model_type, k, cacheParams, cached );
+		if (hasCached && cached.optimal) {
+			// nothing was solved, so there is no CPU time for the log
+			cout << "Cached optimal result\n";
+			cout << "Objective value: " << cached.objectiveValue << "\n";
+			delete cache;
+			return 0;
+		}
+	}
+
 	// read instance
-	Instance instance( file );
+	Instance original( file );
+	Preprocessor preprocessor( original, k );
+	if (preprocessing) {
+		preprocessor.reduce();
+	}
+	Instance& instance = preprocessing ? preprocessor.getReduced() : original;
 	// solve instance
 	double objectiveValue = 0;
 	int nodes = 0;
+	KTree tree; // of exact models, for the cache
+	bool optimal = false;
 	
 	cerr << "Executing " << rounds << " rounds of " << file << " with " << model_type << " k=" << k << "\r\n";
 
-	for (int round=0; round<rounds; round++) {
-		kMST_ILP ilp( instance, model_type, k );
-		ilp.solve();
-		objectiveValue = ilp.getObjectiveValue();
-		nodes = ilp.getNodes();
-	}
+	// errors of the solver end the run
+	try {
+		for (int round=0; round<rounds; round++) {
+			if (model_type == "vns") {
+				// no CPLEX involved
+				kMST_VNS vns( instance, k );
+				if (threads > 0) {
+					vns.setThreads( threads );
+				}
+				vns.setTimeLimit( timeLimit >= 0 ? timeLimit : 10 );
+				vns.solve();
+				objectiveValue = vns.getObjectiveValue();
+				nodes = 0;
+				continue;
+			}
 
-	// log results
-	if (doLogging) {
-		bool exists = false;
-		ifstream logIn(logFilename.c_str());
-		if (logIn) {
-			exists = true;
+			if (model_type == "bnb") {
+				kMST_BnB bnb( instance, k );
+				bnb.setThreads( threads > 0 ? threads : Tools::availableCores() );
+				if (timeLimit >= 0) {
+					bnb.setTimeLimit( timeLimit );
+				}
+				bnb.solve();
+				objectiveValue = bnb.getObjectiveValue();
+				nodes = bnb.getNodes();
+				tree = bnb.getTree();
+				optimal = bnb.isOptimal();
+				continue;
+			}
+
+			if (model_type == "lagrange") {
+				LagrangianBound bound( instance, k );
+				bound.solve();
+				cout << "Lagrangian lower bound: " << bound.getLowerBound() << "\n";
+				cout << "Upper bound: " << bound.getUpperBound() << "\n";
+				cout << "Iterations: " << bound.getIterations() << "\n";
+				objectiveValue = bound.getUpperBound();
+				nodes = 0;
+				continue;
+			}
+
+			if (model_type == "portfolio") {
+				Portfolio portfolio( instance, k, Portfolio::parseModels( portfolioModels ) );
+				portfolio.setThreads( threads );
+				if (timeLimit >= 0) {
+					portfolio.setTimeLimit( timeLimit );
+				}
+				portfolio.solve();
+				cout << "Portfolio winner: " << (portfolio.getWinner().empty() ? "none" : portfolio.getWinner()) << "\n";
+				cout << "Objective value: " << portfolio.getObjectiveValue() << "\n";
+				objectiveValue = portfolio.getObjectiveValue();
+				nodes = portfolio.getNodes();
+				tree = portfolio.getTree();
+				optimal = !portfolio.getWinner().empty();
+				continue;
+			}
+
+			if (sparseNeighbours > 0) {
+				SparseSolver sparse( instance, model_type, k );
+				sparse.setNeighbours( sparseNeighbours );
+				sparse.setThreads( threads );
+				if (timeLimit >= 0) {
+					sparse.setTimeLimit( timeLimit );
+				}
+				sparse.solve();
+				cout << "Sparse rounds: " << sparse.getRounds() << ", core edges: " << sparse.getCoreEdges() << "\n";
+				cout << "Objective value: " << sparse.getObjectiveValue() << "\n";
+				objectiveValue = sparse.getObjectiveValue();
+				nodes = sparse.getNodes();
+				tree = sparse.getTree();
+				optimal = sparse.isOptimal();
+				continue;
+			}
+
+			kMST_ILP ilp( instance, model_type, k );
+			if (!backend.empty()) {
+				ilp.setBackend( backend );
+			}
+			if (lagrangianFixing && k > 0) {
+				LagrangianBound bound( instance, k );
+				bound.solve();
+				cout << "Lagrangian bounds: " << bound.getLowerBound() << " <= opt <= " << bound.getUpperBound() << "\n";
+
+				vector<bool> excludedEdges, excludedVertices;
+				bound.getExclusions(bound.getUpperBound(), excludedEdges, excludedVertices);
+				ilp.setExcludedEdges(excludedEdges);
+			}
+			ilp.setThreads( threads );
+			ilp.setParallelMode( parallelMode );
+			ilp.setMemoryLimits( workMemory, treeMemory );
+			ilp.setVariableNames( variableNames );
+			ilp.setNodeFixing( nodeFixing );
+			ilp.setVertexBranching( vertexBranching );
+			ilp.setLPRepair( repairFrequency, repairBudget );
+			ilp.setProgressInterval( progressInterval );
+			if (hasTarget) {
+				ilp.setProgressTarget( target );
+			}
+			// a cached feasible tree becomes a MIP start, its ids are those of the original instance
+			if (hasCached && !preprocessing) {
+				ilp.setWarmStart( cached.tree );
+			}
+			ilp.solve();
+			objectiveValue = ilp.getObjectiveValue();
+			nodes = ilp.getNodes();
+			tree = ilp.getTree();
+			optimal = ilp.isOptimal();
+
+			if (!progressFilename.empty()) {
+				// one file per run
+				stringstream progressFile, label;
+				progressFile << progressFilename;
+				if (rounds > 1) {
+					progressFile << "." << round;
+				}
+				label << file << " " << model_type << " k=" << k << " round " << round;
+				ilp.getProgress().write( progressFile.str(), label.str() );
+			}
 		}
-		logIn.close();
+	} catch (exception& e) {
+		cerr << e.what() << "\n";
+		exit( -1 );
+	}
 
-		ofstream log;
-		log.open(logFilename.c_str(),ios::ate | ios::app);
- 		if (!exists) {
-			log <<"Filename\tModel\tNodes\tCost\tB&B N\tCPUTime\r\n";
+	if (cache != NULL) {
+		if (tree.isValid()) {
+			ResultCache::Entry entry;
+			entry.objectiveValue = objectiveValue;
+			entry.nodes = nodes;
+			entry.optimal = optimal;
+			entry.tree = preprocessing ? preprocessor.toOriginal(tree) : tree;
+			cache->store( instanceHash, model_type, k, cacheParams, entry );
 		}
-		log <<file <<"\t"<< model_type <<"\t"<< k <<"\t"<< 
-			objectiveValue <<"\t"<< nodes
-			<<"\t"<< Tools::CPUtime()/ rounds<<"\r\n";
- 		log.close();
+		delete cache;
+	}
+
+	// log results
+	if (doLogging) {
+		// exact models without a tree hit a limit before any solution, heuristics always have one
+		bool exact = model_type != "vns" && model_type != "lagrange";
+		bool solved = !exact || tree.isValid();
+		appendLog( logFilename, file, model_type, k, solved, exact && solved && !optimal, objectiveValue, nodes,
+				Tools::CPUtime() / rounds );
 	}
 
 	return 0;
@@ -0,0 +1,105 @@
+#include "MaxFlow.h"
+
+#include <deque>
+#include <algorithm>
+
+static const double EPS = 1e-9;
+
+MaxFlow::MaxFlow( u_int n_nodes ) :
+		n( n_nodes ), outArcs( n_nodes ), level( n_nodes ), current( n_nodes )
+{
+}
+
+u_int MaxFlow::addArc( u_int from, u_int to, double capacity )
+{
+	Arc forward = { to, capacity, 0 };
+	Arc backward = { from, 0, 0 };
+	outArcs[from].push_back( arcs.size() );
+	arcs.push_back( forward );
+	outArcs[to].push_back( arcs.size() );
+	arcs.push_back( backward );
+	return arcs.size() / 2 - 1;
+}
+
+void MaxFlow::setCapacity( u_int arc, double capacity )
+{
+	arcs[2 * arc].capacity = capacity;
+}
+
+double MaxFlow::solve( u_int source, u_int sink, double limit )
+{
+	for (unsigned int i=0; i<arcs.size(); i++) {
+		arcs[i].flow = 0;
+	}
+
+	double totalFlow = 0;
+	if (source == sink) {
+		return totalFlow;
+	}
+
+	while (totalFlow < limit && buildLevels(source, sink)) {
+		fill(current.begin(), current.end(), 0);
+		double pushed;
+		while ((pushed = augment(source, sink, limit - totalFlow)) > EPS) {
+			totalFlow += pushed;
+		}
+	}
+
+	// leave levels valid for the residual reachability query
+	buildLevels(source, sink);
+	return totalFlow;
+}
+
+bool MaxFlow::isSourceSide( u_int node ) const
+{
+	return level[node] >= 0;
+}
+
+// bfs in residual network, true if sink is still reachable
+bool MaxFlow::buildLevels( u_int source, u_int sink )
+{
+	fill(level.begin(), level.end(), -1);
+	level[source] = 0;
+
+	deque<u_int> queue;
+	queue.push_back(source);
+	while (!queue.empty()) {
+		u_int node = queue.front();
+		queue.pop_front();
+
+		for (unsigned int i=0; i<outArcs[node].size(); i++) {
+			const Arc & arc = arcs[ outArcs[node][i] ];
+			if (level[arc.to] < 0 && arc.capacity - arc.flow > EPS) {
+				level[arc.to] = level[node] + 1;
+				queue.push_back(arc.to);
+			}
+		}
+	}
+	return level[sink] >= 0;
+}
+
+// dfs along level graph, returns amount of flow pushed to sink
+double MaxFlow::augment( u_int node, u_int sink, double pushed )
+{
+	if (node == sink) {
+		return pushed;
+	}
+
+	for (; current[node] < outArcs[node].size(); current[node]++) {
+		u_int arcId = outArcs[node][ current[node] ];
+		Arc & arc = arcs[arcId];
+		double residual = arc.capacity - arc.flow;
+
+		if (level[arc.to] != level[node] + 1 || residual <= EPS) {
+			continue;
+		}
+
+		double result = augment(arc.to, sink, min(pushed, residual));
+		if (result > EPS) {
+			arc.flow += result;
+			arcs[arcId ^ 1].flow -= result;
+			return result;
+		}
+	}
+	return 0;
+}
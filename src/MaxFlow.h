@@ -0,0 +1,50 @@
+#ifndef __MAX_FLOW__H__
+#define __MAX_FLOW__H__
+
+#include <vector>
+#include <sys/types.h>
+
+using namespace std;
+
+// max-flow/min-cut on a directed network with real valued capacities (Dinic)
+// arcs keep the id returned by addArc, so capacities can be reset between runs
+class MaxFlow
+{
+
+public:
+
+	MaxFlow( u_int n_nodes );
+
+	// add arc from -> to, returns its id
+	u_int addArc( u_int from, u_int to, double capacity );
+	void setCapacity( u_int arc, double capacity );
+
+	// computes max flow from source to sink, stops early once limit is reached
+	double solve( u_int source, u_int sink, double limit = 1e20 );
+
+	// after solve(): true if node is reachable from source in residual network
+	bool isSourceSide( u_int node ) const;
+
+private:
+
+	struct Arc
+	{
+		u_int to;
+		double capacity, flow;
+	};
+
+	u_int n;
+	// arc 2*i is the arc added by addArc, 2*i+1 its reverse residual arc
+	vector<Arc> arcs;
+	vector<vector<u_int> > outArcs;
+
+	vector<int> level;
+	vector<u_int> current;
+
+	bool buildLevels( u_int source, u_int sink );
+	double augment( u_int node, u_int sink, double pushed );
+
+};
+// MaxFlow
+
+#endif //__MAX_FLOW__H__
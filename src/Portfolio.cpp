@@ -0,0 +1,148 @@
+#include "Portfolio.h"
+
+#include "kMST_ILP.h"
+
+Portfolio::Portfolio( Instance& _instance, int _k, const vector<string>& _models ) :
+		instance( _instance ), k( _k ), models( _models ), threads( 1 ), timeLimit( 0 ), winner( -1 ), failures( 0 ),
+		objectiveValue( 0 ), nodes( 0 )
+{
+	if (models.empty()) {
+		cerr << "empty portfolio\n";
+		exit( -1 );
+	}
+	pthread_mutex_init(&mutex, NULL);
+}
+
+Portfolio::~Portfolio()
+{
+	for (unsigned int i=0; i<ilps.size(); i++) {
+		delete ilps[i];
+	}
+	pthread_mutex_destroy(&mutex);
+}
+
+vector<string> Portfolio::parseModels( string list )
+{
+	vector<string> result;
+	stringstream ss(list);
+	string model;
+	while (getline(ss, model, ',')) {
+		if (model != "scf" && model != "mcf" && model != "mtz" && model != "dcc" && model != "gsec" &&
+				model != "scf-root" && model != "mtz-root" && model != "mcf-lean") {
+			cerr << "unknown portfolio model " << model << "\n";
+			exit( -1 );
+		}
+		result.push_back(model);
+	}
+	return result;
+}
+
+void Portfolio::setThreads( u_int _threads )
+{
+	threads = max(_threads, 1u);
+}
+
+void Portfolio::setTimeLimit( double seconds )
+{
+	timeLimit = seconds;
+}
+
+double Portfolio::getObjectiveValue()
+{
+	return objectiveValue;
+}
+
+int Portfolio::getNodes()
+{
+	return nodes;
+}
+
+string Portfolio::getWinner()
+{
+	return winner >= 0 ? models[winner] : "";
+}
+
+const KTree& Portfolio::getTree()
+{
+	return best;
+}
+
+void Portfolio::solveModel( u_int index )
+{
+	kMST_ILP* ilp = ilps[index];
+	// a failed model doesn't win, the others go on
+	try {
+		ilp->solve();
+	} catch (exception& e) {
+		cerr << "Portfolio: " << models[index] << " failed: " << e.what() << "\n";
+		pthread_mutex_lock(&mutex);
+		failures++;
+		error = e.what();
+		pthread_mutex_unlock(&mutex);
+		return;
+	}
+
+	pthread_mutex_lock(&mutex);
+	if (winner < 0 && ilp->isOptimal()) {
+		winner = index;
+		cout << "Portfolio: " << models[index] << " proved optimality, aborting the others\n";
+		for (unsigned int i=0; i<ilps.size(); i++) {
+			if (i != index) {
+				ilps[i]->abort();
+			}
+		}
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+struct PortfolioWorker
+{
+	Portfolio* portfolio;
+	u_int index;
+};
+
+static void* runPortfolioWorker( void* arg )
+{
+	PortfolioWorker* worker = (PortfolioWorker*)arg;
+	worker->portfolio->solveModel(worker->index);
+	return NULL;
+}
+
+void Portfolio::solve()
+{
+	// all models exist before any thread starts, so abort can reach every one of them
+	for (unsigned int i=0; i<models.size(); i++) {
+		kMST_ILP* ilp = new kMST_ILP( instance, models[i], k );
+		ilp->setThreads( threads );
+		ilp->setTimeLimit( timeLimit );
+		ilp->setSharedIncumbent( &shared );
+		ilps.push_back(ilp);
+	}
+
+	vector<PortfolioWorker> workers(models.size());
+	vector<pthread_t> handles(models.size());
+	for (unsigned int i=0; i<models.size(); i++) {
+		workers[i].portfolio = this;
+		workers[i].index = i;
+	}
+	for (unsigned int i=1; i<models.size(); i++) {
+		pthread_create(&handles[i], NULL, runPortfolioWorker, &workers[i]);
+	}
+	runPortfolioWorker(&workers[0]);
+	for (unsigned int i=1; i<models.size(); i++) {
+		pthread_join(handles[i], NULL);
+	}
+
+	if (failures == models.size()) {
+		throw runtime_error(error);
+	}
+
+	// the winner's value, otherwise the best one found by any model
+	best = shared.getTree();
+	objectiveValue = best.isValid() ? best.weight : 0;
+	nodes = 0;
+	if (winner >= 0) {
+		objectiveValue = ilps[winner]->getObjectiveValue();
+		nodes = ilps[winner]->getNodes();
+	}
+}
@@ -0,0 +1,65 @@
+#ifndef __PORTFOLIO__H__
+#define __PORTFOLIO__H__
+
+#include "Tools.h"
+#include "Instance.h"
+#include "SharedIncumbent.h"
+
+#include <pthread.h>
+
+using namespace std;
+
+class kMST_ILP;
+
+// races several formulations of the same instance and k
+//
+// every model has its own solver and thread, incumbents are shared through a SharedIncumbent
+// and the first model that proves optimality aborts all others
+class Portfolio
+{
+
+public:
+
+	Portfolio( Instance& _instance, int _k, const vector<string>& _models );
+	~Portfolio();
+
+	// comma separated model names
+	static vector<string> parseModels( string list );
+
+	void setThreads( u_int _threads ); // per model
+	void setTimeLimit( double seconds ); // wall clock of every model, <= 0: none
+
+	void solve(); // throws runtime_error with the last error if every model failed
+
+	double getObjectiveValue();
+	int getNodes(); // of the winner
+	string getWinner(); // model that proved optimality, empty if none did
+	const KTree& getTree();
+
+	// used by the workers
+	void solveModel( u_int index );
+
+private:
+
+	Instance& instance;
+	int k;
+	vector<string> models;
+	u_int threads;
+	double timeLimit;
+
+	vector<kMST_ILP*> ilps;
+	SharedIncumbent shared;
+
+	int winner; // index into models, -1 while none proved optimality
+	u_int failures; // models whose solve threw, guarded by mutex
+	string error; // of the last failure
+	pthread_mutex_t mutex;
+
+	KTree best;
+	double objectiveValue;
+	int nodes;
+
+};
+// Portfolio
+
+#endif //__PORTFOLIO__H__
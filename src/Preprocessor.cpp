@@ -0,0 +1,224 @@
+#include "Preprocessor.h"
+
+#include "LagrangianBound.h"
+
+#include <queue>
+#include <climits>
+
+Preprocessor::Preprocessor( const Instance& _original, int _k ) :
+		original( _original ), k( _k ), reduced( NULL ),
+		removedEdges( _original.n_edges, false ), removedVertices( _original.n_nodes, false )
+{
+}
+
+Preprocessor::~Preprocessor()
+{
+	delete reduced;
+}
+
+bool Preprocessor::isRealEdge( u_int edge ) const
+{
+	return original.edges[edge].v1 != 0 && original.edges[edge].v2 != 0;
+}
+
+void Preprocessor::reduce()
+{
+	if (k >= 2) {
+		reducedCostTest();
+		shortestPathTest();
+		componentTest();
+	}
+	buildReduced();
+
+	cout << "Preprocessing removed " << getRemovedVertices() << " vertices and "
+			<< getRemovedEdges() << " edges\n";
+}
+
+void Preprocessor::reducedCostTest()
+{
+	LagrangianBound bound(original, k);
+	bound.solve();
+
+	vector<bool> excludedEdges, excludedVertices;
+	bound.getExclusions(bound.getUpperBound(), excludedEdges, excludedVertices);
+	for (u_int e=0; e<original.n_edges; e++) {
+		removedEdges[e] = removedEdges[e] || excludedEdges[e];
+	}
+	for (u_int v=1; v<original.n_nodes; v++) {
+		removedVertices[v] = removedVertices[v] || excludedVertices[v];
+	}
+}
+
+void Preprocessor::shortestPathTest()
+{
+	typedef pair<long, u_int> Label; // distance, vertex
+	const u_int n = original.n_nodes;
+
+	vector<long> distance(n, LONG_MAX);
+	vector<u_int> reached;
+	vector<bool> remove(original.n_edges, false);
+
+	for (u_int source=1; source<n; source++) {
+		// only paths longer than the heaviest incident edge are of no interest
+		long limit = 0;
+		for (const u_int* iter = original.incidentEdges(source).begin();
+				 iter != original.incidentEdges(source).end(); ++iter) {
+			limit = max(limit, (long)original.edges[*iter].weight);
+		}
+
+		// dijkstra over real vertices and original edges
+		priority_queue<Label, vector<Label>, greater<Label> > queue;
+		distance[source] = 0;
+		reached.push_back(source);
+		queue.push(Label(0, source));
+		while (!queue.empty()) {
+			Label label = queue.top();
+			queue.pop();
+			if (label.first > distance[label.second] || label.first >= limit) {
+				continue;
+			}
+			u_int vertex = label.second;
+			for (const u_int* iter = original.incidentEdges(vertex).begin();
+					 iter != original.incidentEdges(vertex).end(); ++iter) {
+				if (!isRealEdge(*iter)) {
+					continue;
+				}
+				const Instance::Edge & edge = original.edges[*iter];
+				u_int other = (edge.v1 == vertex) ? edge.v2 : edge.v1;
+				long newDistance = label.first + edge.weight;
+				if (newDistance < distance[other]) {
+					if (distance[other] == LONG_MAX) {
+						reached.push_back(other);
+					}
+					distance[other] = newDistance;
+					queue.push(Label(newDistance, other));
+				}
+			}
+		}
+
+		// strictly shorter paths only, shortest paths themselves never get removed
+		for (const u_int* iter = original.incidentEdges(source).begin();
+				 iter != original.incidentEdges(source).end(); ++iter) {
+			const Instance::Edge & edge = original.edges[*iter];
+			u_int other = (edge.v1 == source) ? edge.v2 : edge.v1;
+			if (isRealEdge(*iter) && distance[other] < edge.weight) {
+				remove[*iter] = true;
+			}
+		}
+
+		for (unsigned int i=0; i<reached.size(); i++) {
+			distance[ reached[i] ] = LONG_MAX;
+		}
+		reached.clear();
+	}
+
+	for (u_int e=0; e<original.n_edges; e++) {
+		removedEdges[e] = removedEdges[e] || remove[e];
+	}
+}
+
+void Preprocessor::componentTest()
+{
+	const u_int n = original.n_nodes;
+
+	// components of the remaining real graph
+	vector<int> component(n, -1);
+	vector<u_int> componentSize;
+	for (u_int start=1; start<n; start++) {
+		if (component[start] >= 0 || removedVertices[start]) {
+			continue;
+		}
+		u_int id = componentSize.size();
+		vector<u_int> stack(1, start);
+		component[start] = id;
+		componentSize.push_back(0);
+		while (!stack.empty()) {
+			u_int vertex = stack.back();
+			stack.pop_back();
+			componentSize[id]++;
+			for (const u_int* iter = original.incidentEdges(vertex).begin();
+					 iter != original.incidentEdges(vertex).end(); ++iter) {
+				const Instance::Edge & edge = original.edges[*iter];
+				u_int other = (edge.v1 == vertex) ? edge.v2 : edge.v1;
+				if (!isRealEdge(*iter) || removedEdges[*iter] || removedVertices[other] || component[other] >= 0) {
+					continue;
+				}
+				component[other] = id;
+				stack.push_back(other);
+			}
+		}
+	}
+
+	for (u_int v=1; v<n; v++) {
+		if (!removedVertices[v] && (int)componentSize[ component[v] ] < k) {
+			removedVertices[v] = true;
+		}
+	}
+}
+
+void Preprocessor::buildReduced()
+{
+	const u_int n = original.n_nodes;
+
+	vector<int> newId(n, -1);
+	vertexMap.clear();
+	for (u_int v=0; v<n; v++) {
+		if (v == 0 || !removedVertices[v]) {
+			newId[v] = vertexMap.size();
+			vertexMap.push_back(v);
+		}
+	}
+
+	vector<Instance::Edge> edges;
+	edgeMap.clear();
+	for (u_int e=0; e<original.n_edges; e++) {
+		const Instance::Edge & edge = original.edges[e];
+		if (removedEdges[e] || newId[edge.v1] < 0 || newId[edge.v2] < 0) {
+			removedEdges[e] = true;
+			continue;
+		}
+		Instance::Edge newEdge = { (u_int)newId[edge.v1], (u_int)newId[edge.v2], edge.weight };
+		edges.push_back(newEdge);
+		edgeMap.push_back(e);
+	}
+
+	delete reduced;
+	reduced = new Instance(vertexMap.size(), edges);
+}
+
+Instance& Preprocessor::getReduced()
+{
+	return *reduced;
+}
+
+u_int Preprocessor::originalVertex( u_int vertex ) const
+{
+	return vertexMap[vertex];
+}
+
+u_int Preprocessor::originalEdge( u_int edge ) const
+{
+	return edgeMap[edge];
+}
+
+KTree Preprocessor::toOriginal( const KTree& tree ) const
+{
+	KTree result = tree;
+	for (unsigned int i=0; i<result.vertices.size(); i++) {
+		result.vertices[i] = vertexMap[ result.vertices[i] ];
+	}
+	for (unsigned int i=0; i<result.edges.size(); i++) {
+		result.edges[i] = edgeMap[ result.edges[i] ];
+	}
+	return result;
+}
+
+u_int Preprocessor::getRemovedEdges() const
+{
+	return original.n_edges - edgeMap.size();
+}
+
+u_int Preprocessor::getRemovedVertices() const
+{
+	return original.n_nodes - vertexMap.size();
+}
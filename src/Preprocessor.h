@@ -0,0 +1,58 @@
+#ifndef __PREPROCESSOR__H__
+#define __PREPROCESSOR__H__
+
+#include "Instance.h"
+#include "Heuristic.h"
+
+#include <vector>
+
+using namespace std;
+
+// graph reductions which keep at least one optimal k-tree:
+//  - reduced cost test: edges/vertices in no tree within the upper bound (Lagrangian reduced costs)
+//  - shortest path test: e=(u,v) with a cheaper u-v path over real vertices is in no optimal tree,
+//    replacing it by the path and pruning leaves would be cheaper
+//  - component test: vertices whose component has less than k vertices
+// the artificial root 0 stays node 0, kept vertices and edges are renumbered
+class Preprocessor
+{
+
+public:
+
+	Preprocessor( const Instance& _original, int _k );
+	~Preprocessor();
+
+	// runs all tests, afterwards getReduced() is available
+	void reduce();
+
+	Instance& getReduced();
+
+	// ids of the reduced instance to ids of the original one
+	u_int originalVertex( u_int vertex ) const;
+	u_int originalEdge( u_int edge ) const;
+	KTree toOriginal( const KTree& tree ) const;
+
+	u_int getRemovedEdges() const;
+	u_int getRemovedVertices() const;
+
+private:
+
+	const Instance& original;
+	int k;
+
+	Instance* reduced;
+	vector<u_int> vertexMap, edgeMap; // reduced -> original
+
+	vector<bool> removedEdges, removedVertices;
+
+	void reducedCostTest();
+	void shortestPathTest();
+	void componentTest();
+	void buildReduced();
+
+	bool isRealEdge( u_int edge ) const;
+
+};
+// Preprocessor
+
+#endif //__PREPROCESSOR__H__
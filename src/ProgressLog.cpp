@@ -0,0 +1,185 @@
+#include "ProgressLog.h"
+
+#include <fstream>
+
+ProgressLog::ProgressLog() :
+		interval( 1 ), hasTarget( false ), target( 0 ), startTime( 0 )
+{
+	pthread_mutex_init(&mutex, NULL);
+}
+
+ProgressLog::~ProgressLog()
+{
+	pthread_mutex_destroy(&mutex);
+}
+
+void ProgressLog::setInterval( double seconds )
+{
+	interval = max(seconds, 0.0);
+}
+
+void ProgressLog::setTarget( double _target )
+{
+	hasTarget = true;
+	target = _target;
+}
+
+void ProgressLog::start()
+{
+	samples.clear();
+	fixings.clear();
+	startTime = Tools::wallTime();
+}
+
+void ProgressLog::add( int nodes, bool feasible, double incumbent, double bound, int cuts )
+{
+	Sample sample;
+	sample.time = Tools::wallTime() - startTime;
+	sample.nodes = nodes;
+	sample.feasible = feasible;
+	sample.incumbent = feasible ? incumbent : 0;
+	sample.bound = bound;
+	sample.gap = feasible ? fabs(incumbent - bound) / max(fabs(incumbent), 1e-10) : 0;
+	sample.cuts = cuts;
+	sample.memory = Tools::residentMemory();
+	sample.fixed = fixings.empty() ? 0 : fixings.back().variables;
+	samples.push_back(sample);
+}
+
+void ProgressLog::record( int nodes, bool feasible, double incumbent, double bound, int cuts )
+{
+	pthread_mutex_lock(&mutex);
+	bool keep = samples.empty();
+	if (!keep) {
+		const Sample& last = samples.back();
+		bool improved = feasible && (!last.feasible || incumbent < last.incumbent - 1e-9);
+		bool changed = (bound > last.bound + 1e-9 || nodes != last.nodes);
+		keep = improved || (changed && Tools::wallTime() - startTime - last.time >= interval);
+	}
+	if (keep) {
+		add(nodes, feasible, incumbent, bound, cuts);
+	}
+	pthread_mutex_unlock(&mutex);
+}
+
+void ProgressLog::finish( int nodes, bool feasible, double incumbent, double bound, int cuts )
+{
+	pthread_mutex_lock(&mutex);
+	add(nodes, feasible, incumbent, bound, cuts);
+	pthread_mutex_unlock(&mutex);
+}
+
+void ProgressLog::recordFixing( double incumbent, int newVariables )
+{
+	pthread_mutex_lock(&mutex);
+	if (fixings.empty() || fixings.back().incumbent != incumbent) {
+		Fixing fixing;
+		fixing.time = Tools::wallTime() - startTime;
+		fixing.incumbent = incumbent;
+		fixing.variables = fixing.nodes = 0;
+		fixings.push_back(fixing);
+	}
+	fixings.back().variables += newVariables;
+	fixings.back().nodes++;
+	pthread_mutex_unlock(&mutex);
+}
+
+const vector<ProgressLog::Sample>& ProgressLog::getSamples() const
+{
+	return samples;
+}
+
+const vector<ProgressLog::Fixing>& ProgressLog::getFixings() const
+{
+	return fixings;
+}
+
+int ProgressLog::getFixedVariables() const
+{
+	return fixings.empty() ? 0 : fixings.back().variables;
+}
+
+int ProgressLog::getFixingNodes() const
+{
+	int nodes = 0;
+	for (unsigned int i=0; i<fixings.size(); i++) {
+		nodes += fixings[i].nodes;
+	}
+	return nodes;
+}
+
+double ProgressLog::getTimeToFirstFeasible() const
+{
+	for (unsigned int i=0; i<samples.size(); i++) {
+		if (samples[i].feasible) {
+			return samples[i].time;
+		}
+	}
+	return -1;
+}
+
+double ProgressLog::getTimeToBest() const
+{
+	if (samples.empty() || !samples.back().feasible) {
+		return -1;
+	}
+	// incumbents only improve, so the first one as good as the last
+	for (unsigned int i=0; i<samples.size(); i++) {
+		if (samples[i].feasible && samples[i].incumbent <= samples.back().incumbent + 1e-9) {
+			return samples[i].time;
+		}
+	}
+	return -1;
+}
+
+double ProgressLog::getTimeToTarget() const
+{
+	if (!hasTarget) {
+		return -1;
+	}
+	for (unsigned int i=0; i<samples.size(); i++) {
+		if (samples[i].feasible && samples[i].incumbent <= target + 1e-9) {
+			return samples[i].time;
+		}
+	}
+	return -1;
+}
+
+double ProgressLog::getTotalTime() const
+{
+	return samples.empty() ? 0 : samples.back().time;
+}
+
+void ProgressLog::write( string file, string label ) const
+{
+	ofstream out( file.c_str() );
+	if( out.fail() ) {
+		cerr << "could not open progress file " << file << "\n";
+		exit( -1 );
+	}
+
+	out << "# " << label << "\n";
+	out << "# first feasible " << getTimeToFirstFeasible() << "s, best found " << getTimeToBest()
+			<< "s, finished " << getTotalTime() << "s";
+	if (hasTarget) {
+		out << ", target " << target << " reached " << getTimeToTarget() << "s";
+	}
+	out << "\n";
+	for (unsigned int i=0; i<fixings.size(); i++) {
+		out << "# fixed " << fixings[i].variables << " variables by reduced costs against " << fixings[i].incumbent
+				<< " from " << fixings[i].time << "s on, at " << fixings[i].nodes << " nodes\n";
+	}
+
+	out << "time\tnodes\tincumbent\tbound\tgap\tcuts\tmemory\tfixed\n";
+	for (unsigned int i=0; i<samples.size(); i++) {
+		const Sample& s = samples[i];
+		out << s.time << "\t" << s.nodes << "\t";
+		if (s.feasible) {
+			out << s.incumbent << "\t" << s.bound << "\t" << s.gap;
+		} else {
+			out << "-\t" << s.bound << "\t-";
+		}
+		out << "\t" << s.cuts << "\t" << s.memory << "\t" << s.fixed << "\n";
+	}
+	out.close();
+}
@@ -0,0 +1,84 @@
+#ifndef __PROGRESS_LOG__H__
+#define __PROGRESS_LOG__H__
+
+#include "Tools.h"
+
+#include <pthread.h>
+
+using namespace std;
+
+// incumbent and bound of one CPLEX solve over time
+//
+// fed by a MIP info callback, a sample is kept on every improvement of the incumbent
+// and otherwise at most once per interval; times are seconds since start()
+class ProgressLog
+{
+
+public:
+
+	struct Sample
+	{
+		double time;
+		int nodes;
+		bool feasible; // incumbent and gap only valid if true
+		double incumbent, bound, gap;
+		int cuts; // generated by CPLEX
+		double memory; // resident set size in MB
+		int fixed; // distinct arcs and vertices fixed by reduced costs against the current incumbent
+	};
+
+	// reduced cost fixing against one incumbent, aggregated over the nodes
+	struct Fixing
+	{
+		double time; // of the first node
+		double incumbent;
+		int variables; // distinct arcs and vertices
+		int nodes; // whose branches carried fixings
+	};
+
+	ProgressLog();
+	~ProgressLog();
+
+	void setInterval( double seconds ); // 0: keep every change of incumbent or bound
+	void setTarget( double _target ); // objective value for the time to target
+
+	void start();
+	void record( int nodes, bool feasible, double incumbent, double bound, int cuts );
+	void finish( int nodes, bool feasible, double incumbent, double bound, int cuts ); // always kept
+	// a node which fixed variables against incumbent, newVariables of them were not fixed before
+	void recordFixing( double incumbent, int newVariables );
+
+	const vector<Sample>& getSamples() const;
+	const vector<Fixing>& getFixings() const;
+	int getFixedVariables() const; // against the last incumbent
+	int getFixingNodes() const; // over all incumbents
+
+	// seconds since start, -1 if never reached
+	double getTimeToFirstFeasible() const;
+	double getTimeToBest() const; // when the final incumbent was found
+	double getTimeToTarget() const;
+	double getTotalTime() const;
+
+	// tab separated, summary as comment lines in front
+	void write( string file, string label ) const;
+
+private:
+
+	double interval;
+	bool hasTarget;
+	double target;
+
+	double startTime;
+	vector<Sample> samples;
+	vector<Fixing> fixings;
+	pthread_mutex_t mutex; // info callbacks may run on several threads
+
+	void add( int nodes, bool feasible, double incumbent, double bound, int cuts );
+
+	ProgressLog( const ProgressLog& );
+	ProgressLog& operator=( const ProgressLog& );
+
+};
+// ProgressLog
+
+#endif //__PROGRESS_LOG__H__
@@ -0,0 +1,146 @@
+#include "ResultCache.h"
+
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+static const char* CACHE_MAGIC = "kmst-result";
+static const int CACHE_VERSION = 1;
+
+static const unsigned long long FNV_OFFSET = 14695981039346656037ULL;
+static const unsigned long long FNV_PRIME = 1099511628211ULL;
+
+static unsigned long long fnv1a( unsigned long long hash, const char* data, size_t size )
+{
+	for (size_t i=0; i<size; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= FNV_PRIME;
+	}
+	return hash;
+}
+
+static string toHex( unsigned long long hash )
+{
+	stringstream ss;
+	ss << hex << setw(16) << setfill('0') << hash;
+	return ss.str();
+}
+
+ResultCache::ResultCache( string _directory ) :
+		directory( _directory )
+{
+	if (mkdir( directory.c_str(), 0777 ) != 0) {
+		struct stat status;
+		if (stat( directory.c_str(), &status ) != 0 || !S_ISDIR( status.st_mode )) {
+			cerr << "could not create cache directory " << directory << "\n";
+			exit( -1 );
+		}
+	}
+}
+
+string ResultCache::hashFile( string file )
+{
+	int fd = open( file.c_str(), O_RDONLY );
+	if( fd < 0 ) {
+		cerr << "could not open input file " << file << "\n";
+		exit( -1 );
+	}
+	unsigned long long hash = FNV_OFFSET;
+	char buffer[1 << 16];
+	ssize_t size;
+	while ((size = read( fd, buffer, sizeof( buffer ) )) > 0) {
+		hash = fnv1a( hash, buffer, size );
+	}
+	close( fd );
+	return toHex( hash );
+}
+
+string ResultCache::path( string instanceHash, string model, int k, string params ) const
+{
+	stringstream key;
+	key << instanceHash << "\t" << model << "\t" << k << "\t" << params;
+	string keyString = key.str();
+	return directory + "/" + toHex( fnv1a( FNV_OFFSET, keyString.data(), keyString.size() ) ) + ".result";
+}
+
+bool ResultCache::lookup( string instanceHash, string model, int k, string params, Entry& entry ) const
+{
+	ifstream ifs( path( instanceHash, model, k, params ).c_str() );
+	if( ifs.fail() ) {
+		return false;
+	}
+
+	// the whole key is stored, so a collision of the file names is no hit
+	string magic, storedHash, storedModel, storedParams;
+	int version, storedK;
+	getline(ifs, magic, '\t');
+	ifs >> version;
+	ifs.ignore();
+	getline(ifs, storedHash, '\t');
+	getline(ifs, storedModel, '\t');
+	ifs >> storedK;
+	ifs.ignore();
+	getline(ifs, storedParams);
+	if (!ifs || magic != CACHE_MAGIC || version != CACHE_VERSION || storedHash != instanceHash ||
+			storedModel != model || storedK != k || storedParams != params) {
+		return false;
+	}
+
+	Entry read;
+	u_int vertices, edges;
+	ifs >> read.objectiveValue >> read.nodes >> read.optimal >> read.tree.weight >> vertices;
+	read.tree.vertices.resize(vertices);
+	for (u_int i=0; i<vertices && ifs; i++) {
+		ifs >> read.tree.vertices[i];
+	}
+	ifs >> edges;
+	read.tree.edges.resize(edges);
+	for (u_int i=0; i<edges && ifs; i++) {
+		ifs >> read.tree.edges[i];
+	}
+	if (!ifs) {
+		return false; // truncated, e.g. by a crash of an older version
+	}
+	entry = read;
+	return true;
+}
+
+void ResultCache::store( string instanceHash, string model, int k, string params, const Entry& entry )
+{
+	Entry existing;
+	if (lookup( instanceHash, model, k, params, existing ) && (existing.optimal ||
+			(!entry.optimal && existing.objectiveValue <= entry.objectiveValue))) {
+		return;
+	}
+
+	string file = path( instanceHash, model, k, params );
+	stringstream temporary;
+	temporary << file << ".tmp." << getpid() << "." << (unsigned long)pthread_self();
+	ofstream out( temporary.str().c_str() );
+	if( out.fail() ) {
+		cerr << "could not write cache entry " << temporary.str() << "\n";
+		return;
+	}
+
+	out << CACHE_MAGIC << "\t" << CACHE_VERSION << "\t" << instanceHash << "\t" << model << "\t" << k << "\t"
+			<< params << "\n";
+	out << entry.objectiveValue << "\t" << entry.nodes << "\t" << (entry.optimal ? 1 : 0) << "\t"
+			<< entry.tree.weight << "\n";
+	out << entry.tree.vertices.size();
+	for (unsigned int i=0; i<entry.tree.vertices.size(); i++) {
+		out << " " << entry.tree.vertices[i];
+	}
+	out << "\n" << entry.tree.edges.size();
+	for (unsigned int i=0; i<entry.tree.edges.size(); i++) {
+		out << " " << entry.tree.edges[i];
+	}
+	out << "\n";
+	out.close();
+
+	if (rename( temporary.str().c_str(), file.c_str() ) != 0) {
+		cerr << "could not write cache entry " << file << "\n";
+		unlink( temporary.str().c_str() );
+	}
+}
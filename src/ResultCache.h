@@ -0,0 +1,47 @@
+#ifndef __RESULT_CACHE__H__
+#define __RESULT_CACHE__H__
+
+#include "Tools.h"
+#include "Heuristic.h"
+
+using namespace std;
+
+// results of earlier solves on disk, one file per instance, model, k and parameters
+//
+// instances are identified by a FNV-1a hash of their file contents, so a lookup needs no
+// parsing; trees are stored with the ids of the original instance
+class ResultCache
+{
+
+public:
+
+	struct Entry
+	{
+		double objectiveValue;
+		int nodes;
+		bool optimal; // otherwise the tree is only a start for the next solve
+		KTree tree;
+	};
+
+	ResultCache( string _directory ); // created if it doesn't exist
+
+	// 16 hex digits, exits if the file can't be read
+	static string hashFile( string file );
+
+	// false if there is no entry for exactly this key
+	bool lookup( string instanceHash, string model, int k, string params, Entry& entry ) const;
+
+	// keeps an existing entry unless the new one is optimal or better,
+	// written to a temporary file and renamed, so concurrent jobs never see half an entry
+	void store( string instanceHash, string model, int k, string params, const Entry& entry );
+
+private:
+
+	string directory;
+
+	string path( string instanceHash, string model, int k, string params ) const;
+
+};
+// ResultCache
+
+#endif //__RESULT_CACHE__H__
@@ -0,0 +1,54 @@
+#include "SharedIncumbent.h"
+
+SharedIncumbent::SharedIncumbent() :
+		version( 0 )
+{
+	pthread_mutex_init(&mutex, NULL);
+}
+
+SharedIncumbent::~SharedIncumbent()
+{
+	pthread_mutex_destroy(&mutex);
+}
+
+bool SharedIncumbent::offer( const KTree& tree )
+{
+	bool improved = false;
+	pthread_mutex_lock(&mutex);
+	if (tree.isValid() && tree.weight < best.weight) {
+		best = tree;
+		version++;
+		improved = true;
+	}
+	pthread_mutex_unlock(&mutex);
+	return improved;
+}
+
+bool SharedIncumbent::poll( u_int& _version, KTree& tree )
+{
+	bool newer = false;
+	pthread_mutex_lock(&mutex);
+	if (_version < version) {
+		tree = best;
+		_version = version;
+		newer = true;
+	}
+	pthread_mutex_unlock(&mutex);
+	return newer;
+}
+
+int SharedIncumbent::getWeight()
+{
+	pthread_mutex_lock(&mutex);
+	int weight = best.weight;
+	pthread_mutex_unlock(&mutex);
+	return weight;
+}
+
+KTree SharedIncumbent::getTree()
+{
+	pthread_mutex_lock(&mutex);
+	KTree tree = best;
+	pthread_mutex_unlock(&mutex);
+	return tree;
+}
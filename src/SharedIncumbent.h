@@ -0,0 +1,42 @@
+#ifndef __SHARED_INCUMBENT__H__
+#define __SHARED_INCUMBENT__H__
+
+#include "Heuristic.h"
+
+#include <pthread.h>
+
+using namespace std;
+
+// best tree found by any of several concurrently solved models
+//
+// every improvement gets a new version, so a model only picks up trees it hasn't seen yet
+class SharedIncumbent
+{
+
+public:
+
+	SharedIncumbent();
+	~SharedIncumbent();
+
+	// true if the tree is better than the current one and replaced it
+	bool offer( const KTree& tree );
+
+	// copies the best tree if it is newer than version and updates version
+	bool poll( u_int& version, KTree& tree );
+
+	int getWeight(); // INT_MAX if there is none yet
+	KTree getTree();
+
+private:
+
+	KTree best;
+	u_int version;
+	pthread_mutex_t mutex;
+
+	SharedIncumbent( const SharedIncumbent& );
+	SharedIncumbent& operator=( const SharedIncumbent& );
+
+};
+// SharedIncumbent
+
+#endif //__SHARED_INCUMBENT__H__
@@ -0,0 +1,210 @@
+#include "SparseSolver.h"
+
+#include "kMST_ILP.h"
+#include "LagrangianBound.h"
+
+#include <cmath>
+#include <algorithm>
+
+SparseSolver::SparseSolver( const Instance& _instance, string _model_type, int _k ) :
+		instance( _instance ), model_type( _model_type ), k( _k ), neighbours( 5 ), pricingBatch( 0 ),
+		threads( 0 ), timeLimit( 0 ), objectiveValue( 0 ), nodes( 0 ), optimal( false ), rounds( 0 ),
+		coreEdges( 0 )
+{
+	if( k == 0 ) k = instance.n_nodes - 1;
+	pricingBatch = instance.n_nodes;
+}
+
+void SparseSolver::setNeighbours( u_int _neighbours )
+{
+	neighbours = _neighbours;
+}
+
+void SparseSolver::setPricingBatch( u_int _pricingBatch )
+{
+	pricingBatch = _pricingBatch;
+}
+
+void SparseSolver::setThreads( u_int _threads )
+{
+	threads = _threads;
+}
+
+void SparseSolver::setTimeLimit( double seconds )
+{
+	timeLimit = seconds;
+}
+
+void SparseSolver::initialCore( const KTree& start )
+{
+	inCore.assign(instance.n_edges, false);
+
+	// the root edges cost nothing and every vertex may need its own
+	for (const u_int* iter = instance.incidentEdges(0).begin();
+			 iter != instance.incidentEdges(0).end(); ++iter) {
+		inCore[*iter] = true;
+	}
+	for (unsigned int i=0; i<start.edges.size(); i++) {
+		inCore[ start.edges[i] ] = true;
+	}
+
+	// cheapest edges per vertex, except those which can't beat the start tree
+	vector<pair<int, u_int> > incident;
+	for (u_int v=1; v<instance.n_nodes; v++) {
+		incident.clear();
+		for (const u_int* iter = instance.incidentEdges(v).begin();
+				 iter != instance.incidentEdges(v).end(); ++iter) {
+			const Instance::Edge & edge = instance.edges[*iter];
+			if (edge.v1 != 0 && edge.v2 != 0 && edgeBounds[*iter] < start.weight - 0.5) {
+				incident.push_back(pair<int, u_int>(edge.weight, *iter));
+			}
+		}
+		u_int count = min((u_int)incident.size(), neighbours);
+		partial_sort(incident.begin(), incident.begin() + count, incident.end());
+		for (u_int i=0; i<count; i++) {
+			inCore[ incident[i].second ] = true;
+		}
+	}
+}
+
+u_int SparseSolver::price()
+{
+	// integral weights: an improving solution costs at most objectiveValue - 1
+	vector<pair<double, u_int> > candidates;
+	for (u_int e=0; e<instance.n_edges; e++) {
+		if (!inCore[e] && ceil(edgeBounds[e] - 1e-6) < objectiveValue - 0.5) {
+			candidates.push_back(pair<double, u_int>(edgeBounds[e], e));
+		}
+	}
+
+	u_int count = candidates.size();
+	if (pricingBatch > 0) {
+		count = min(count, pricingBatch);
+	}
+	partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+	for (u_int i=0; i<count; i++) {
+		inCore[ candidates[i].second ] = true;
+	}
+	return count;
+}
+
+Instance* SparseSolver::buildCore( vector<u_int>& edgeMap )
+{
+	vector<Instance::Edge> edges;
+	edgeMap.clear();
+	for (u_int e=0; e<instance.n_edges; e++) {
+		if (inCore[e]) {
+			edges.push_back(instance.edges[e]);
+			edgeMap.push_back(e);
+		}
+	}
+	return new Instance(instance.n_nodes, edges);
+}
+
+void SparseSolver::solve()
+{
+	double start = Tools::wallTime();
+	nodes = 0;
+	rounds = 0;
+	optimal = false;
+
+	LagrangianBound bound( instance, k );
+	if (threads > 0) {
+		bound.setThreads( threads );
+	}
+	bound.solve();
+	bound.getEdgeBounds( edgeBounds );
+	best = bound.getTree();
+	objectiveValue = best.weight;
+	cout << "Lagrangian bounds: " << bound.getLowerBound() << " <= opt <= " << bound.getUpperBound() << "\n";
+
+	if (!best.isValid()) {
+		cerr << "no k-tree in the instance\n";
+		objectiveValue = 0;
+		return;
+	}
+	if (ceil(bound.getLowerBound() - 1e-6) >= best.weight) {
+		cout << "Lagrangian tree is optimal\n";
+		optimal = true;
+		return;
+	}
+
+	initialCore( best );
+	while (true) {
+		rounds++;
+		vector<u_int> edgeMap;
+		Instance* core = buildCore( edgeMap );
+		coreEdges = core->n_edges;
+		cout << "Sparse round " << rounds << ": " << coreEdges << " of " << instance.n_edges << " edges\n";
+
+		// best tree so far in ids of the core
+		vector<int> coreId(instance.n_edges, -1);
+		for (unsigned int i=0; i<edgeMap.size(); i++) {
+			coreId[ edgeMap[i] ] = i;
+		}
+		KTree warmStart = best;
+		for (unsigned int i=0; i<warmStart.edges.size(); i++) {
+			warmStart.edges[i] = coreId[ warmStart.edges[i] ];
+		}
+
+		bool solved = false;
+		{
+			kMST_ILP ilp( *core, model_type, k );
+			ilp.setThreads( threads );
+			if (timeLimit > 0) {
+				double remaining = timeLimit - (Tools::wallTime() - start);
+				ilp.setTimeLimit( max(remaining, 1e-3) );
+			}
+			ilp.setWarmStart( warmStart );
+			ilp.solve();
+			nodes += ilp.getNodes();
+			solved = ilp.isOptimal();
+
+			KTree tree = ilp.getTree();
+			if (tree.isValid() && tree.weight < best.weight) {
+				for (unsigned int i=0; i<tree.edges.size(); i++) {
+					tree.edges[i] = edgeMap[ tree.edges[i] ];
+				}
+				best = tree;
+			}
+		}
+		delete core;
+		objectiveValue = best.weight;
+
+		if (!solved) {
+			cout << "Sparse core not solved to optimality, stopping\n";
+			break;
+		}
+
+		u_int priced = price();
+		cout << "Priced in: " << priced << " edges\n";
+		if (priced == 0) {
+			optimal = true;
+			break;
+		}
+	}
+}
+
+double SparseSolver::getObjectiveValue() {
+	return objectiveValue;
+}
+
+int SparseSolver::getNodes() {
+	return nodes;
+}
+
+bool SparseSolver::isOptimal() {
+	return optimal;
+}
+
+const KTree& SparseSolver::getTree() {
+	return best;
+}
+
+int SparseSolver::getRounds() {
+	return rounds;
+}
+
+u_int SparseSolver::getCoreEdges() {
+	return coreEdges;
+}
@@ -0,0 +1,66 @@
+#ifndef __SPARSE_SOLVER__H__
+#define __SPARSE_SOLVER__H__
+
+#include "Tools.h"
+#include "Instance.h"
+#include "Heuristic.h"
+
+using namespace std;
+
+// solves a CPLEX model on a sparse core of the edges and prices the remaining ones in
+//
+// the first core holds the cheapest edges of every vertex, the root edges and the Lagrangian tree;
+// an edge outside the core is priced by its Lagrangian bound (no solution containing it is cheaper),
+// edges which may beat the optimum of the core are added cheapest first and the core is solved again,
+// until no such edge is left and the optimum of the core is optimal for the whole graph
+class SparseSolver
+{
+
+public:
+
+	SparseSolver( const Instance& _instance, string _model_type, int _k );
+
+	void setNeighbours( u_int _neighbours ); // cheapest edges per vertex in the first core
+	void setPricingBatch( u_int _pricingBatch ); // edges added per round, 0: all candidates
+	void setThreads( u_int _threads );
+	void setTimeLimit( double seconds ); // of all rounds, the result is not proven optimal if it is hit
+
+	void solve();
+
+	double getObjectiveValue();
+	int getNodes(); // of all rounds
+	bool isOptimal();
+	const KTree& getTree(); // ids of the original instance
+	int getRounds();
+	u_int getCoreEdges(); // of the last round
+
+private:
+
+	const Instance& instance;
+	string model_type;
+	int k;
+	u_int neighbours;
+	u_int pricingBatch;
+	u_int threads;
+	double timeLimit;
+
+	vector<bool> inCore;
+	vector<double> edgeBounds; // Lagrangian bound per edge
+
+	double objectiveValue;
+	int nodes;
+	bool optimal;
+	KTree best;
+	int rounds;
+	u_int coreEdges;
+
+	void initialCore( const KTree& start );
+	u_int price(); // adds edges to the core, returns their number
+
+	// instance of the core edges (all vertices keep their ids), edgeMap: core edge -> original edge
+	Instance* buildCore( vector<u_int>& edgeMap );
+
+};
+// SparseSolver
+
+#endif //__SPARSE_SOLVER__H__
@@ -4,6 +4,7 @@
 #include "Tools.h"
 
 #include <deque>
+#include <unistd.h>
 
 string Tools::indicesToString( string prefix, int i, int j, int v )
 {
@@ -37,6 +38,60 @@ double Tools::CPUtime()
 	return t.tms_utime / ct;
 }
 
+double Tools::wallTime()
+{
+	timeval t;
+	gettimeofday( &t, NULL );
+	return t.tv_sec + t.tv_usec / 1e6;
+}
+
+u_int Tools::availableCores()
+{
+	long cores = sysconf( _SC_NPROCESSORS_ONLN );
+	return cores > 0 ? cores : 1;
+}
+
+double Tools::residentMemory()
+{
+	FILE* statm = fopen( "/proc/self/statm", "r" );
+	if (statm == NULL) {
+		return 0;
+	}
+	unsigned long size = 0, resident = 0;
+	if (fscanf( statm, "%lu %lu", &size, &resident ) != 2) {
+		resident = 0;
+	}
+	fclose( statm );
+	return resident * (double)sysconf( _SC_PAGESIZE ) / (1024 * 1024);
+}
+
+double Tools::peakMemory()
+{
+	FILE* status = fopen( "/proc/self/status", "r" );
+	if (status == NULL) {
+		return 0;
+	}
+	char line[256];
+	unsigned long peak = 0;
+	while (fgets( line, sizeof( line ), status ) != NULL) {
+		if (sscanf( line, "VmHWM: %lu kB", &peak ) == 1) {
+			break;
+		}
+	}
+	fclose( status );
+	return peak / 1024.0;
+}
+
+void Tools::resetPeakMemory()
+{
+	// "5" resets the peak to the current resident set size (Linux 4.0 and later)
+	FILE* clearRefs = fopen( "/proc/self/clear_refs", "w" );
+	if (clearRefs != NULL) {
+		fputs( "5", clearRefs );
+		fclose( clearRefs );
+	}
+}
+
 Tools::Tree::Tree(int sz) : tree(sz)
 {
 	//cerr << "\nsz: "<<sz <<"\n" << endl;
@@ -8,11 +8,13 @@
 #include <ctime>
 #include <stdexcept>
 #include <vector>
+#include <list>
 #include <string>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
 #include <sys/times.h>
+#include <sys/time.h>
 #include "Instance.h"
 
 using namespace std;
@@ -27,6 +29,19 @@ namespace Tools
 	// measure running time
 	double CPUtime();
 
+	// wall clock time in seconds
+	double wallTime();
+
+	// number of online processors, at least 1
+	u_int availableCores();
+
+	// resident set size of the process in MB, 0 if unknown
+	double residentMemory();
+
+	// highest resident set size in MB since the last reset (or the start), 0 if unknown
+	double peakMemory();
+	void resetPeakMemory();
+
 	struct Tree {
 		vector<list<pair<int, float> > > tree;
 		Tree(int sz);
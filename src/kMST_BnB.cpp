@@ -0,0 +1,628 @@
+#include "kMST_BnB.h"
+
+#include "LagrangianBound.h"
+
+#include <climits>
+#include <cstring>
+#include <sched.h>
+
+// ----- node pool -----------------------------------------------------
+
+static const u_int NODES_PER_CHUNK = 1024;
+
+kMST_BnB::NodePool::NodePool( size_t _nodeSize ) :
+		nodeSize( (_nodeSize + 7) & ~(size_t)7 )
+{
+}
+
+kMST_BnB::NodePool::~NodePool()
+{
+	for (unsigned int i=0; i<chunks.size(); i++) {
+		delete[] chunks[i];
+	}
+}
+
+kMST_BnB::Node* kMST_BnB::NodePool::allocate()
+{
+	if (freeNodes.empty()) {
+		char* chunk = new char[nodeSize * NODES_PER_CHUNK];
+		chunks.push_back(chunk);
+		for (u_int i=0; i<NODES_PER_CHUNK; i++) {
+			freeNodes.push_back((Node*)(chunk + i * nodeSize));
+		}
+	}
+	Node* node = freeNodes.back();
+	freeNodes.pop_back();
+	return node;
+}
+
+void kMST_BnB::NodePool::release( Node* node )
+{
+	freeNodes.push_back(node);
+}
+
+// ----- public methods ------------------------------------------------
+
+kMST_BnB::kMST_BnB( const Instance& _instance, int _k ) :
+		instance( _instance ), k( _k ), threads( 1 ), timeLimit( -1 ), nodeIterations( 10 ), heuristic( _instance, _k ),
+		pending( 0 ), timeout( false ), startTime( 0 ), rootBound( 0 ), optimal( false )
+{
+	pthread_mutex_init(&pendingMutex, NULL);
+}
+
+kMST_BnB::~kMST_BnB()
+{
+	pthread_mutex_destroy(&pendingMutex);
+}
+
+void kMST_BnB::setThreads( u_int _threads )
+{
+	threads = max(_threads, 1u);
+}
+
+void kMST_BnB::setTimeLimit( double seconds )
+{
+	timeLimit = seconds;
+}
+
+void kMST_BnB::setNodeIterations( int iterations )
+{
+	nodeIterations = max(iterations, 1);
+}
+
+double kMST_BnB::getObjectiveValue()
+{
+	return best.isValid() ? best.weight : 0;
+}
+
+double kMST_BnB::getRootBound()
+{
+	return rootBound;
+}
+
+long kMST_BnB::getNodes()
+{
+	long nodes = 0;
+	for (unsigned int i=0; i<workers.size(); i++) {
+		nodes += workers[i].processed;
+	}
+	return nodes;
+}
+
+bool kMST_BnB::isOptimal()
+{
+	return optimal;
+}
+
+const KTree& kMST_BnB::getTree()
+{
+	return best;
+}
+
+struct BnBWorker
+{
+	kMST_BnB* bnb;
+	u_int index;
+};
+
+static void* runBnBWorker( void* arg )
+{
+	BnBWorker* worker = (BnBWorker*)arg;
+	worker->bnb->work(worker->index);
+	return NULL;
+}
+
+void kMST_BnB::solve()
+{
+	const u_int n = instance.n_nodes, m = instance.n_edges;
+	startTime = Tools::wallTime();
+
+	// multipliers, start tree and reduced cost exclusions of the root
+	LagrangianBound lagrange( instance, k );
+	lagrange.setThreads( threads );
+	lagrange.solve();
+	incumbent.offer(lagrange.getTree());
+	rootBound = lagrange.getLowerBound();
+	cout << "Root bounds: " << rootBound << " <= opt <= " << incumbent.getWeight() << "\n";
+
+	lagrange.getMultipliers(rootAlpha, rootGamma1, rootGamma2);
+	if (rootAlpha.empty()) {
+		// no subgradient steps were run, the nodes start from zero
+		rootAlpha.assign(n, 0);
+		rootGamma1.assign(m, 0);
+		rootGamma2.assign(m, 0);
+	}
+	vector<bool> excludedEdges, excludedVertices;
+	lagrange.getExclusions(incumbent.getWeight() - 1, excludedEdges, excludedVertices);
+
+	// real edges by increasing Lagrangian cost of the root
+	vector<pair<double, u_int> > order;
+	for (u_int e=0; e<m; e++) {
+		if (!excludedEdges[e] && heuristic.isRealEdge(e)) {
+			double cost = instance.edges.weight[e] - rootAlpha[ instance.edges.v1[e] ]
+					- rootAlpha[ instance.edges.v2[e] ] + rootGamma1[e] + rootGamma2[e];
+			order.push_back(pair<double, u_int>(cost, e));
+		}
+	}
+	sort(order.begin(), order.end());
+	sortedEdges.clear();
+	for (unsigned int i=0; i<order.size(); i++) {
+		sortedEdges.push_back(order[i].second);
+	}
+
+	workers.resize(threads);
+	vector<NodePool*> pools;
+	for (u_int i=0; i<threads; i++) {
+		Worker& worker = workers[i];
+		pthread_mutex_init(&worker.mutex, NULL);
+		pools.push_back(new NodePool(sizeof(Node) + n));
+		worker.pool = pools.back();
+		worker.parent.assign(n, 0);
+		worker.stamp.assign(n, 0);
+		worker.currentStamp = 0;
+		worker.edgeCost.assign(m, 0);
+		worker.vertexCost.assign(n, 0);
+		worker.selected.assign(n, 0);
+		worker.covered.assign(n, 0);
+		worker.lastFree = worker.nextFree = 0;
+		worker.bestLastFree = worker.bestNextFree = 0;
+		worker.processed = 0;
+	}
+
+	// root node, vertex 0 is the artificial root
+	Node* root = workers[0].pool->allocate();
+	root->bound = rootBound;
+	u_char* status = root->status();
+	for (u_int v=0; v<n; v++) {
+		status[v] = (v == 0 || excludedVertices[v]) ? OUT : FREE;
+	}
+	pending = 0;
+	timeout = false;
+	push(workers[0], root);
+
+	vector<BnBWorker> args(threads);
+	vector<pthread_t> handles(threads);
+	for (u_int i=0; i<threads; i++) {
+		args[i].bnb = this;
+		args[i].index = i;
+	}
+	for (u_int i=1; i<threads; i++) {
+		pthread_create(&handles[i], NULL, runBnBWorker, &args[i]);
+	}
+	runBnBWorker(&args[0]);
+	for (u_int i=1; i<threads; i++) {
+		pthread_join(handles[i], NULL);
+	}
+
+	// nodes can only be left over after a timeout, nodes may live in another worker's pool
+	for (u_int i=0; i<threads; i++) {
+		for (unsigned int j=0; j<workers[i].nodes.size(); j++) {
+			workers[i].pool->release(workers[i].nodes[j]);
+		}
+		workers[i].nodes.clear();
+		pthread_mutex_destroy(&workers[i].mutex);
+	}
+	for (unsigned int i=0; i<pools.size(); i++) {
+		delete pools[i];
+	}
+
+	best = incumbent.getTree();
+	optimal = !timeout && best.isValid();
+	cout << "Branch-and-bound nodes: " << getNodes() << (optimal ? "" : " (not finished)") << "\n";
+	cout << "Objective value: " << getObjectiveValue() << "\n";
+}
+
+// ----- search --------------------------------------------------------
+
+void kMST_BnB::push( Worker& worker, Node* node )
+{
+	pthread_mutex_lock(&pendingMutex);
+	pending++;
+	pthread_mutex_unlock(&pendingMutex);
+
+	pthread_mutex_lock(&worker.mutex);
+	worker.nodes.push_back(node);
+	pthread_mutex_unlock(&worker.mutex);
+}
+
+kMST_BnB::Node* kMST_BnB::pop( u_int index )
+{
+	Node* node = NULL;
+
+	// newest own node keeps the search depth first
+	Worker& own = workers[index];
+	pthread_mutex_lock(&own.mutex);
+	if (!own.nodes.empty()) {
+		node = own.nodes.back();
+		own.nodes.pop_back();
+	}
+	pthread_mutex_unlock(&own.mutex);
+
+	// oldest node of another worker, the root of the largest open subtree
+	for (u_int i=1; i<threads && node == NULL; i++) {
+		Worker& victim = workers[(index + i) % threads];
+		pthread_mutex_lock(&victim.mutex);
+		if (!victim.nodes.empty()) {
+			node = victim.nodes.front();
+			victim.nodes.pop_front();
+		}
+		pthread_mutex_unlock(&victim.mutex);
+	}
+	return node;
+}
+
+void kMST_BnB::finished()
+{
+	pthread_mutex_lock(&pendingMutex);
+	pending--;
+	pthread_mutex_unlock(&pendingMutex);
+}
+
+void kMST_BnB::work( u_int index )
+{
+	Worker& worker = workers[index];
+	bool stopped = false; // copy of timeout, looked up every 256 nodes
+	while (true) {
+		Node* node = pop(index);
+		if (node == NULL) {
+			pthread_mutex_lock(&pendingMutex);
+			bool done = (pending == 0);
+			pthread_mutex_unlock(&pendingMutex);
+			if (done) {
+				break;
+			}
+			sched_yield();
+			continue;
+		}
+
+		if (!stopped && (worker.processed & 255) == 0) {
+			pthread_mutex_lock(&pendingMutex);
+			if (timeLimit >= 0 && Tools::wallTime() - startTime > timeLimit) {
+				timeout = true;
+			}
+			stopped = timeout;
+			pthread_mutex_unlock(&pendingMutex);
+		}
+		if (stopped) {
+			// drain the open nodes
+			worker.pool->release(node);
+			finished();
+			continue;
+		}
+		process(worker, node);
+	}
+}
+
+u_int kMST_BnB::find( Worker& worker, u_int v )
+{
+	// vertices not touched since the last reset are singletons
+	if (worker.stamp[v] != worker.currentStamp) {
+		worker.stamp[v] = worker.currentStamp;
+		worker.parent[v] = v;
+		return v;
+	}
+	while (worker.parent[v] != v) {
+		worker.parent[v] = worker.parent[ worker.parent[v] ];
+		v = worker.parent[v];
+	}
+	return v;
+}
+
+// drops vertices which can't be connected to the fixed ones in k-1 hops, false if infeasible
+bool kMST_BnB::connect( Worker& worker, u_char* status )
+{
+	const u_int n = instance.n_nodes;
+
+	int allowed = 0;
+	int start = -1;
+	for (u_int v=0; v<n; v++) {
+		if (status[v] != OUT) {
+			allowed++;
+		}
+		if (status[v] == IN && start < 0) {
+			start = v;
+		}
+	}
+	if (allowed < k) {
+		return false;
+	}
+	if (start < 0) {
+		return true;
+	}
+
+	// bfs with hop limit from the first fixed vertex, the stamp marks reached vertices
+	worker.currentStamp++;
+	vector<u_int>& queue = worker.queue;
+	vector<u_int>& depth = worker.parent; // free until the bound runs
+	queue.clear();
+	queue.push_back(start);
+	worker.stamp[start] = worker.currentStamp;
+	depth[start] = 0;
+	for (unsigned int i=0; i<queue.size(); i++) {
+		u_int v = queue[i];
+		if ((int)depth[v] >= k - 1) {
+			continue;
+		}
+		Instance::Span next = instance.neighbours(v);
+		for (const u_int* iter = next.begin(); iter != next.end(); ++iter) {
+			if (status[*iter] != OUT && worker.stamp[*iter] != worker.currentStamp) {
+				worker.stamp[*iter] = worker.currentStamp;
+				depth[*iter] = depth[v] + 1;
+				queue.push_back(*iter);
+			}
+		}
+	}
+	if ((int)queue.size() < k) {
+		return false;
+	}
+	for (u_int v=0; v<n; v++) {
+		if (worker.stamp[v] != worker.currentStamp && status[v] != OUT) {
+			if (status[v] == IN) {
+				return false;
+			}
+			status[v] = OUT;
+		}
+	}
+	return true;
+}
+
+// relaxation for the multipliers of the worker: k-1 cheapest acyclic edges between allowed vertices
+// plus the fixed and the cheapest free vertices, HUGE_VAL if there are not enough of either
+double kMST_BnB::evaluate( Worker& worker, const u_char* status )
+{
+	const u_int n = instance.n_nodes;
+
+	for (u_int v=0; v<n; v++) {
+		worker.vertexCost[v] = worker.alpha[v];
+		worker.covered[v] = 0;
+		worker.selected[v] = (status[v] == IN);
+	}
+	for (unsigned int i=0; i<worker.edgeOrder.size(); i++) {
+		u_int e = worker.edgeOrder[i];
+		u_int v1 = instance.edges.v1[e], v2 = instance.edges.v2[e];
+		worker.edgeCost[e] = instance.edges.weight[e] - worker.alpha[v1] - worker.alpha[v2]
+				+ worker.gamma1[e] + worker.gamma2[e];
+		worker.vertexCost[v1] -= worker.gamma1[e];
+		worker.vertexCost[v2] -= worker.gamma2[e];
+	}
+
+	// insertion sort, the order of the previous step is almost right
+	vector<u_int>& order = worker.edgeOrder;
+	for (unsigned int i=1; i<order.size(); i++) {
+		u_int e = order[i];
+		double cost = worker.edgeCost[e];
+		unsigned int j = i;
+		for (; j > 0 && worker.edgeCost[ order[j-1] ] > cost; j--) {
+			order[j] = order[j-1];
+		}
+		order[j] = e;
+	}
+
+	// forest, greedy is optimal on the truncated graphic matroid
+	worker.currentStamp++;
+	worker.forest.clear();
+	double value = 0;
+	for (unsigned int i=0; i<order.size() && (int)worker.forest.size() < k-1; i++) {
+		u_int e = order[i];
+		u_int v1 = instance.edges.v1[e], v2 = instance.edges.v2[e];
+		if (status[v1] == OUT || status[v2] == OUT) {
+			continue;
+		}
+		u_int a = find(worker, v1), b = find(worker, v2);
+		if (a == b) {
+			continue;
+		}
+		worker.parent[a] = b;
+		worker.forest.push_back(e);
+		worker.covered[v1]++;
+		worker.covered[v2]++;
+		value += worker.edgeCost[e];
+	}
+	if ((int)worker.forest.size() < k-1) {
+		return HUGE_VAL;
+	}
+
+	// fixed vertices plus the cheapest free ones
+	int needed = k;
+	worker.candidates.clear();
+	for (u_int v=1; v<n; v++) {
+		if (status[v] == IN) {
+			value += worker.vertexCost[v];
+			needed--;
+		} else if (status[v] == FREE) {
+			worker.candidates.push_back(pair<double, u_int>(worker.vertexCost[v], v));
+		}
+	}
+	if (needed < 0 || (int)worker.candidates.size() < needed) {
+		return HUGE_VAL;
+	}
+	worker.lastFree = -HUGE_VAL;
+	worker.nextFree = HUGE_VAL;
+	if (needed > 0) {
+		nth_element(worker.candidates.begin(), worker.candidates.begin() + (needed - 1), worker.candidates.end());
+		for (int i=0; i<needed; i++) {
+			worker.selected[ worker.candidates[i].second ] = 1;
+			value += worker.candidates[i].first;
+		}
+		worker.lastFree = worker.candidates[needed - 1].first;
+	}
+	for (unsigned int i=needed; i<worker.candidates.size(); i++) {
+		worker.nextFree = min(worker.nextFree, worker.candidates[i].first);
+	}
+	return value;
+}
+
+// best relaxation over some subgradient steps from the root multipliers, fixes vertices by
+// reduced costs; branchVertex is -1 if all selected vertices are fixed, HUGE_VAL if infeasible
+double kMST_BnB::bound( Worker& worker, u_char* status, int& branchVertex )
+{
+	const u_int n = instance.n_nodes;
+	branchVertex = -1;
+
+	worker.alpha = rootAlpha;
+	worker.gamma1 = rootGamma1;
+	worker.gamma2 = rootGamma2;
+	worker.edgeOrder = sortedEdges;
+
+	int upperBound = incumbent.getWeight();
+	double limit = upperBound - 1 + 1e-6; // weights are integral
+	double best = -HUGE_VAL;
+	double stepFactor = 1;
+
+	for (int iteration=0; iteration<nodeIterations; iteration++) {
+		double value = evaluate(worker, status);
+		if (value == HUGE_VAL) {
+			return value;
+		}
+		if (value > best) {
+			best = value;
+			worker.bestSelected = worker.selected;
+			worker.bestCovered = worker.covered;
+			worker.bestVertexCost = worker.vertexCost;
+			worker.bestLastFree = worker.lastFree;
+			worker.bestNextFree = worker.nextFree;
+		} else {
+			stepFactor /= 2;
+		}
+		if (best > limit || iteration + 1 == nodeIterations) {
+			break;
+		}
+
+		// subgradients of y_v - x(delta(v)) <= 0 and x_e - y_u <= 0 as in LagrangianBound
+		vector<double>& alphaGradient = worker.vertexCost; // reused, the best costs are saved
+		for (u_int v=0; v<n; v++) {
+			alphaGradient[v] = worker.selected[v] - (double)worker.covered[v];
+		}
+		double norm = 0;
+		for (u_int v=1; v<n; v++) {
+			if (worker.alpha[v] > 0 || alphaGradient[v] > 0) norm += alphaGradient[v] * alphaGradient[v];
+		}
+		const vector<u_char>& y = worker.selected;
+		for (unsigned int i=0; i<worker.edgeOrder.size(); i++) {
+			u_int e = worker.edgeOrder[i];
+			double g1 = -(double)y[ instance.edges.v1[e] ], g2 = -(double)y[ instance.edges.v2[e] ];
+			if (worker.gamma1[e] > 0 || g1 > 0) norm += g1 * g1;
+			if (worker.gamma2[e] > 0 || g2 > 0) norm += g2 * g2;
+		}
+		for (unsigned int i=0; i<worker.forest.size(); i++) {
+			// x_e = 1 changes the gradient of the forest edges from -y to 1-y
+			u_int e = worker.forest[i];
+			double g1 = -(double)y[ instance.edges.v1[e] ], g2 = -(double)y[ instance.edges.v2[e] ];
+			if (worker.gamma1[e] > 0 || g1 > 0) norm -= g1 * g1;
+			if (worker.gamma2[e] > 0 || g2 > 0) norm -= g2 * g2;
+			norm += (1 + g1) * (1 + g1) + (1 + g2) * (1 + g2);
+		}
+		if (norm <= 0) {
+			break; // relaxed solution is a k-tree
+		}
+
+		double step = stepFactor * (upperBound - value) / norm;
+		for (u_int v=1; v<n; v++) {
+			worker.alpha[v] = max(0.0, worker.alpha[v] + step * alphaGradient[v]);
+		}
+		for (unsigned int i=0; i<worker.edgeOrder.size(); i++) {
+			u_int e = worker.edgeOrder[i];
+			worker.gamma1[e] = max(0.0, worker.gamma1[e] - step * y[ instance.edges.v1[e] ]);
+			worker.gamma2[e] = max(0.0, worker.gamma2[e] - step * y[ instance.edges.v2[e] ]);
+		}
+		for (unsigned int i=0; i<worker.forest.size(); i++) {
+			// undo the step above and apply the one with x_e = 1
+			u_int e = worker.forest[i];
+			worker.gamma1[e] = max(0.0, worker.gamma1[e] + step * (1 - y[ instance.edges.v1[e] ]));
+			worker.gamma2[e] = max(0.0, worker.gamma2[e] + step * (1 - y[ instance.edges.v2[e] ]));
+		}
+	}
+	if (best > limit) {
+		return best;
+	}
+
+	// reduced costs of the best step: swapping a vertex in resp. out must stay below the incumbent
+	int needed = k;
+	for (u_int v=1; v<n; v++) {
+		if (status[v] == IN) {
+			needed--;
+		}
+	}
+	for (u_int v=1; v<n; v++) {
+		if (status[v] != FREE) {
+			continue;
+		}
+		if (needed == 0) {
+			status[v] = OUT; // the tree consists of the fixed vertices
+		} else if (!worker.bestSelected[v] && best + worker.bestVertexCost[v] - worker.bestLastFree > limit) {
+			status[v] = OUT;
+		} else if (worker.bestSelected[v] && best - worker.bestVertexCost[v] + worker.bestNextFree > limit) {
+			status[v] = IN;
+		}
+	}
+
+	// branch where the relaxation violates the linking constraints: forest edges at unselected
+	// vertices first, then selected vertices without a forest edge, then any free selected one
+	int bestScore = -1;
+	for (u_int v=1; v<n; v++) {
+		if (status[v] != FREE) {
+			continue;
+		}
+		int score = -1;
+		if (!worker.bestSelected[v] && worker.bestCovered[v] > 0) {
+			score = 2 * n + worker.bestCovered[v];
+		} else if (worker.bestSelected[v] && worker.bestCovered[v] == 0) {
+			score = n;
+		} else if (worker.bestSelected[v]) {
+			score = worker.bestCovered[v] > 1 ? 0 : 1;
+		}
+		if (score > bestScore) {
+			bestScore = score;
+			branchVertex = v;
+		}
+	}
+	return best;
+}
+
+void kMST_BnB::process( Worker& worker, Node* node )
+{
+	const u_int n = instance.n_nodes;
+	worker.processed++;
+
+	u_char* status = node->status();
+	int branchVertex = -1;
+
+	if (ceil(node->bound - 1e-6) < incumbent.getWeight() && connect(worker, status)) {
+		double value = bound(worker, status, branchVertex);
+		if (value != HUGE_VAL && ceil(value - 1e-6) < incumbent.getWeight()) {
+
+			// spanning tree on the selected vertices
+			vector<u_int> selected;
+			for (u_int v=1; v<n; v++) {
+				if (worker.bestSelected[v]) {
+					selected.push_back(v);
+				}
+			}
+			KTree candidate = heuristic.spanningTree(selected);
+			if (candidate.isValid() && candidate.weight < incumbent.getWeight()) {
+				heuristic.improve(candidate);
+				if (incumbent.offer(candidate)) {
+					cout << "Incumbent " << candidate.weight << " after " << worker.processed << " nodes\n";
+				}
+			}
+
+			// otherwise all selected vertices are fixed and the spanning tree solves the node
+			if (branchVertex >= 0 && ceil(value - 1e-6) < incumbent.getWeight()) {
+				Node* out = worker.pool->allocate();
+				Node* in = worker.pool->allocate();
+				out->bound = in->bound = value;
+				memcpy(out->status(), status, n);
+				memcpy(in->status(), status, n);
+				out->status()[branchVertex] = OUT;
+				in->status()[branchVertex] = IN;
+
+				// inclusion is searched first
+				push(worker, out);
+				push(worker, in);
+			}
+		}
+	}
+
+	worker.pool->release(node);
+	finished();
+}
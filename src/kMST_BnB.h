@@ -0,0 +1,140 @@
+#ifndef __K_MST_BNB__H__
+#define __K_MST_BNB__H__
+
+#include "Tools.h"
+#include "Instance.h"
+#include "Heuristic.h"
+#include "SharedIncumbent.h"
+
+#include <deque>
+#include <pthread.h>
+
+using namespace std;
+
+// exact combinatorial branch-and-bound, needs no CPLEX
+//
+// branches on including or excluding a vertex; nodes are bounded by the Lagrangian relaxation of
+// LagrangianBound (k cheapest vertices plus k-1 cheapest acyclic edges), whose multipliers are
+// reoptimized for a few subgradient steps per node starting from the ones of the root;
+// every thread runs a depth first search on its own deque and steals from the others when idle
+class kMST_BnB
+{
+
+public:
+
+	// fixing of a vertex in a node
+	enum Status { FREE = 0, IN = 1, OUT = 2 };
+
+	// search node, followed by one status byte per vertex in the same allocation
+	struct Node
+	{
+		double bound; // of the parent, the node can be dropped if the incumbent gets better
+		u_char* status() { return (u_char*)(this + 1); }
+	};
+
+	// fixed size node allocations in chunks, released nodes are reused
+	class NodePool
+	{
+	public:
+		NodePool( size_t _nodeSize );
+		~NodePool();
+		Node* allocate();
+		void release( Node* node );
+	private:
+		size_t nodeSize;
+		vector<char*> chunks;
+		vector<Node*> freeNodes;
+		NodePool( const NodePool& );
+		NodePool& operator=( const NodePool& );
+	};
+
+	// state of one thread
+	struct Worker
+	{
+		deque<Node*> nodes; // own end is the back, thieves take from the front
+		pthread_mutex_t mutex;
+		NodePool* pool;
+
+		// multipliers and costs of the node, edges stay almost sorted between subgradient steps
+		vector<double> alpha, gamma1, gamma2;
+		vector<double> edgeCost, vertexCost;
+		vector<u_int> edgeOrder;
+
+		// union-find of the forest, reset in O(1) by a new stamp
+		vector<u_int> parent, stamp;
+		u_int currentStamp;
+
+		// relaxed solution: selected vertices, forest edges and forest degree per vertex
+		vector<u_char> selected;
+		vector<u_int> forest, covered;
+		double lastFree, nextFree; // most expensive selected and cheapest unselected free vertex
+
+		// of the best iteration, for fixing and branching
+		vector<u_char> bestSelected;
+		vector<u_int> bestCovered;
+		vector<double> bestVertexCost;
+		double bestLastFree, bestNextFree;
+
+		vector<pair<double, u_int> > candidates;
+		vector<u_int> queue;
+		long processed;
+	};
+
+	kMST_BnB( const Instance& _instance, int _k );
+	~kMST_BnB();
+
+	void setThreads( u_int _threads );
+	void setTimeLimit( double seconds ); // result is not proven optimal if it is hit
+	void setNodeIterations( int iterations ); // subgradient steps per node
+
+	void solve();
+
+	double getObjectiveValue();
+	double getRootBound();
+	long getNodes();
+	bool isOptimal();
+	const KTree& getTree();
+
+	// used by the workers
+	void work( u_int index );
+
+private:
+
+	const Instance& instance;
+	int k;
+	u_int threads;
+	double timeLimit;
+	int nodeIterations;
+
+	KTreeHeuristic heuristic;
+	SharedIncumbent incumbent;
+
+	// multipliers of the root, real edges sorted by their Lagrangian cost
+	vector<double> rootAlpha, rootGamma1, rootGamma2;
+	vector<u_int> sortedEdges;
+
+	vector<Worker> workers;
+	long pending; // nodes queued or in process, the search is over at 0
+	bool timeout; // set by any worker
+	pthread_mutex_t pendingMutex; // of pending and timeout
+
+	double startTime;
+	double rootBound;
+	KTree best;
+	bool optimal;
+
+	void process( Worker& worker, Node* node );
+	bool connect( Worker& worker, u_char* status );
+	double bound( Worker& worker, u_char* status, int& branchVertex );
+	double evaluate( Worker& worker, const u_char* status );
+
+	void push( Worker& worker, Node* node );
+	Node* pop( u_int index );
+	void finished(); // a node was processed, after its children were pushed
+
+	u_int find( Worker& worker, u_int v );
+
+};
+// kMST_BnB
+
+#endif //__K_MST_BNB__H__
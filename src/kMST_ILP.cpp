@@ -1,167 +1,444 @@
 #include "kMST_ILP.h"
+#include "LagrangianBound.h"
+
+// ----- callbacks -----------------------------------------------------
+
+// rows of the exponentially large models violated by the given values of all columns
+// directed (dcc): sum_{a in delta+(S)} x_a >= y_t
+// undirected (gsec): sum_{e in E(S)} x_e <= sum_{v in S, v != t} y_v
+// mcf-lean: flow <= edge
+void kMST_ILP::separate( const vector<double>& values, vector<MILPBackend::Row>& rows, double minViolation )
+{
+	if (model_type == "dcc" || model_type == "gsec") {
+		vector<double> edgeValues(edges.size()), vertexValues(vertices.size());
+		for (unsigned int i=0; i<edges.size(); i++) {
+			edgeValues[i] = values[ edges[i] ];
+		}
+		for (unsigned int i=0; i<vertices.size(); i++) {
+			vertexValues[i] = values[ vertices[i] ];
+		}
+
+		if (model_type == "dcc") {
+			vector<CutSeparator::DirectedCut> found;
+			separator.separateDirectedCuts(edgeValues, vertexValues, found, minViolation);
+
+			for (unsigned int i=0; i<found.size(); i++) {
+				MILPBackend::Row cut;
+				for (unsigned int j=0; j<found[i].arcs.size(); j++) {
+					cut.expr.add(edges[ found[i].arcs[j] ], 1);
+				}
+				cut.expr.add(vertices[ found[i].target ], -1);
+				cut.lb = 0;
+				cut.ub = MILPBackend::INF;
+				rows.push_back(cut);
+			}
+		} else {
+			vector<CutSeparator::SubtourCut> found;
+			separator.separateSubtourCuts(edgeValues, vertexValues, found, minViolation);
+
+			for (unsigned int i=0; i<found.size(); i++) {
+				MILPBackend::Row cut;
+				for (unsigned int j=0; j<found[i].edges.size(); j++) {
+					cut.expr.add(edges[ found[i].edges[j] ], 1);
+				}
+				for (unsigned int j=0; j<found[i].vertices.size(); j++) {
+					if (found[i].vertices[j] != found[i].target) {
+						cut.expr.add(vertices[ found[i].vertices[j] ], -1);
+					}
+				}
+				cut.lb = -MILPBackend::INF;
+				cut.ub = 0;
+				rows.push_back(cut);
+			}
+		}
+	}
+
+	if (mcfLean) {
+		for (unsigned int commodity=0; commodity<flow_mcf.size(); commodity++) {
+			for (unsigned int position=0; position<flow_mcf[commodity].size(); position++) {
+				int flow = flow_mcf[commodity][position];
+				int edge = edges[ mcfLayout.arcs[position] ];
+				if (values[flow] > values[edge] + minViolation) {
+					MILPBackend::Row coupling;
+					coupling.expr.add(flow, 1);
+					coupling.expr.add(edge, -1);
+					coupling.lb = -MILPBackend::INF;
+					coupling.ub = 0;
+					rows.push_back(coupling);
+				}
+			}
+		}
+	}
+}
+
+// integer solutions: reject every disconnected one resp. flow on arcs which are not selected
+void kMST_ILP::separateLazy( const vector<double>& values, vector<MILPBackend::Row>& rows )
+{
+	separate(values, rows, 1e-6);
+}
+
+// fractional solutions: only add clearly violated cuts to avoid tailing off
+void kMST_ILP::separateCuts( const vector<double>& values, vector<MILPBackend::Row>& rows )
+{
+	separate(values, rows, 1e-2);
+}
+
+// trees found by the other models are tried first, they act as cutoff from then on;
+// otherwise the LP point of the node is rounded to a k-tree, rate limited
+bool kMST_ILP::findSolution( const MILPBackend::Node& node, MILPBackend::Expr& start, double& objective )
+{
+	KTree tree;
+	bool found = pollSharedIncumbent(tree) && (!node.hasIncumbent() || tree.weight < node.getIncumbent() - 0.5);
+
+	if (!found && repairFrequency > 0 && isRepairDue(node.getNodes())) {
+		vector<double> edgeValues(edges.size());
+		for (unsigned int i=0; i<edges.size(); i++) {
+			edgeValues[i] = node.getValue(edges[i]);
+		}
+		tree = repairTree(edgeValues);
+		found = tree.isValid() && (!node.hasIncumbent() || tree.weight < node.getIncumbent() - 0.5);
+	}
+	if (!found) {
+		return false;
+	}
+
+	treeToValues(tree, start);
+	objective = tree.weight;
+	return true;
+}
+
+// vertex branching: branches on the most fractional y_v while there is one, the arcs are left to the solver
+//
+// node fixing: fixes arcs, their flows and vertices which can't be part of a solution better than the
+// incumbent in every child, so they hold in the subtree of the node
+void kMST_ILP::branch( MILPBackend::BranchNode& node )
+{
+	if (nodeFixing && node.hasIncumbent()) {
+		vector<u_int> candidates;
+		getFixingCandidates(node.getIncumbent(), candidates);
+
+		vector<u_int> fixed;
+		vector<int> fixedColumns;
+		for (unsigned int i=0; i<candidates.size(); i++) {
+			// fixed with its companions at an ancestor already
+			int column = getFixingColumn(candidates[i]);
+			if (node.getUpperBound(column) > 0.5) {
+				fixed.push_back(candidates[i]);
+				fixedColumns.push_back(column);
+				addFixingCompanions(candidates[i], fixedColumns);
+			}
+		}
+		for (unsigned int i=0; i<fixedColumns.size(); i++) {
+			node.fixToZero(fixedColumns[i]);
+		}
+		if (!fixed.empty()) {
+			recordFixing(node.getIncumbent(), fixed);
+		}
+	}
+
+	if (vertexBranching) {
+		int vertex = -1;
+		double fraction = 1e-6;
+		for (unsigned int v=1; v<vertices.size(); v++) {
+			double value = node.getValue(vertices[v]);
+			if (min(value, 1 - value) > fraction) {
+				fraction = min(value, 1 - value);
+				vertex = v;
+			}
+		}
+		if (vertex >= 0) {
+			node.branchOn(vertices[vertex]);
+		}
+	}
+}
+
+// records when the root node is done (its processing is the root LP plus cuts and heuristics)
+// and samples incumbent and bound for the progress log
+void kMST_ILP::progress( const MILPBackend::Progress& state )
+{
+	if (rootEnd < 0 && state.nodes > 0) {
+		rootEnd = Tools::wallTime();
+	}
+	progressLog.record(state.nodes, state.feasible, state.incumbent, state.bound, state.cuts);
+}
+
+// offers every new incumbent to the models solved concurrently (weights are integral)
+void kMST_ILP::incumbent( const vector<double>& values, double objective )
+{
+	if (shared == NULL || objective > shared->getWeight() - 0.5) {
+		return;
+	}
+	shared->offer(valuesToTree(values));
+}
+
+// ----- public methods ------------------------------------------------
+
+static const bool DO_LOGGING = false;
 
 kMST_ILP::kMST_ILP( Instance& _instance, string _model_type, int _k ) :
-		instance( _instance ), model_type( _model_type ), k( _k )
+		instance( _instance ), model_type( _model_type ), k( _k ), backendName( MILPBackend::defaultName() ),
+		backend( NULL ), columns( 0 ), uMin( 0 ), separator( _instance ), rootSymmetry( false ), names( false ),
+		mcfLean( false ), nodeFixing( false ), vertexBranching( false ), repairFrequency( 0 ), repairBudget( 0 ),
+		threads( 0 ), parallelMode( MILPBackend::DETERMINISTIC ), workMemory( 0 ), treeMemory( 0 ), timeLimit( 0 ),
+		built( false ), optimal( false ), uSumLimit( -1 ), fixingIncumbent( -1 ), repairNextNode( 0 ),
+		repairRuns( 0 ), repairTime( 0 ), nodes( 0 ), objectiveValue( 0 ), rootEnd( -1 ), aborted( false )
 {
+	pthread_mutex_init(&fixingMutex, NULL);
+	pthread_mutex_init(&repairMutex, NULL);
+	pthread_mutex_init(&abortMutex, NULL);
+	timings.build = timings.extraction = timings.rootLP = timings.branchAndBound = 0;
+	shared = NULL;
+	sharedVersion = 0;
 	n = instance.n_nodes;
 	m = instance.n_edges;
-	if( k == 0 ) k = n;
+	// 0: all vertices but the artificial root, as in the other solvers
+	if( k == 0 ) k = n - 1;
+
+	// same model with explicit vertices and the root fixed to the smallest of them
+	if (model_type == "scf-root" || model_type == "mtz-root") {
+		model_type = model_type.substr(0, 3);
+		rootSymmetry = true;
+	}
+	if (model_type == "mcf-lean") {
+		model_type = "mcf";
+		mcfLean = true;
+	}
 }
 
-void kMST_ILP::solve()
+void kMST_ILP::buildModel()
 {
-	try {
-		bool DO_LOGGING = false;
-		// initialize CPLEX
-		env = IloEnv();
-		model = IloModel( env );
+	double start = Tools::wallTime();
+
+	// initialize the solver, an abort may have come first
+	MILPBackend* created = MILPBackend::create( backendName );
+	pthread_mutex_lock(&abortMutex);
+	backend = created;
+	if (aborted) {
+		backend->abort();
+	}
+	pthread_mutex_unlock(&abortMutex);
+
+	// separated rows are part of the model, the other hooks only speed it up
+	int hooks = getHooks();
+	int required = hooks & (MILPBackend::LAZY | MILPBackend::USER_CUTS);
+	if ((required & ~backend->getSupportedHooks()) != 0) {
+		cerr << "model " << model_type << (mcfLean ? "-lean" : "") << " needs callbacks, which backend "
+				<< backendName << " doesn't have\n";
+		exit( -1 );
+	}
+	if ((hooks & ~backend->getSupportedHooks()) != 0) {
+		cout << "Backend " << backendName << " has no callbacks, node fixing, vertex branching, "
+				<< "LP repair, shared incumbents and progress samples are left out\n";
+		hooks &= backend->getSupportedHooks();
+	}
 
+	if( model_type == "gsec" ) {
+		modelGSEC(); // undirected, initialises edges itself
+	} else {
 		addTreeConstraints(); // call first, initialises edges
 
 		// add model-specific constraints
 		if( model_type == "scf" ) modelSCF();
 		else if( model_type == "mcf" ) modelMCF();
 		else if( model_type == "mtz" ) modelMTZ();
+		else if( model_type == "dcc" ) modelDCC();
 		else {
 			cerr << "No existing model chosen\n";
 			exit( -1 );
 		}
 
-		addObjectiveFunction();
+		if ((rootSymmetry || vertexBranching) && model_type != "dcc") {
+			addVertexVariables();
+		}
+		if (rootSymmetry) {
+			addRootSymmetryBreaking();
+		}
+	}
 
-		// build model
-		cplex = IloCplex( model );
-		// export model to a text file
-		//cplex.exportModel( "model.lp" );
-		// set parameters
-		setCPLEXParameters();
+	applyExclusions();
 
-		// turn off logging
-		if (!DO_LOGGING) {
-			cplex.setOut(env.getNullStream());
-		}
+	double extractionStart = Tools::wallTime();
+	timings.build = extractionStart - start;
 
-		// solve model
-		cout << "Calling CPLEX solve ...\n";
-		cplex.solve();
-		cout << "CPLEX finished.\n\n";
+	backend->setCallback(this, hooks);
+	setParameters();
+	backend->extract();
 
-		nodes = cplex.getNnodes();
-		objectiveValue = cplex.getObjValue();
+	timings.extraction = Tools::wallTime() - extractionStart;
+	built = true;
+}
 
-		cout << "CPLEX status: " << cplex.getStatus() << "\n";
-		cout << "Branch-and-Bound nodes: " << nodes << "\n";
-		cout << "Objective value: " << objectiveValue  << "\n";
-		cout << "CPU time: " << Tools::CPUtime() << "\n\n";
+void kMST_ILP::solve()
+{
+	timings.build = timings.extraction = 0;
+	if (!built) {
+		buildModel();
+	}
+	setParameters();
 
-		// show result
-		IloNumArray edgesSelected(env, edges.getSize()), flowRes(env, edges.getSize()), uRes(env, instance.n_nodes);
-		cplex.getValues(edgesSelected, edges);
+	// starts for another k are infeasible now
+	backend->clearMIPStarts();
 
-		if (model_type == "scf") {
-			cplex.getValues(flowRes, flow_scf);
-		} else if (model_type == "mtz") {
-			try {
-				cplex.getValues(uRes, u);
-			} catch ( IloException& e ) {
-				cerr << "Exception while extracting u: " << e << endl;
-				uRes = IloNumArray(env, 0);
-			}
+	// give the solver an incumbent right from the start
+	{
+		KTreeHeuristic heuristic(instance, k);
+		KTree start = heuristic.solve(threads > 0 ? threads : Tools::availableCores());
+		if (start.isValid()) {
+			cout << "Heuristic solution: " << start.weight << "\n";
+			addMIPStart(start);
 		}
-		if (DO_LOGGING) {
-		cout << "Edges:\n";
-
-		stringstream edgeLabels; // for debug output MCF
-		edgeLabels << "EDGE";
 
-		Tools::Tree tree(instance.n_nodes);
+		KTree resized = heuristic.resize(warmStart);
+		heuristic.improve(resized);
+		if (resized.isValid() && resized.weight < start.weight) {
+			cout << "Warm start solution: " << resized.weight << "\n";
+			addMIPStart(resized);
+		}
+		warmStart = KTree();
+
+		// bounds for k, candidates are computed again for the first incumbent
+		if (nodeFixing) {
+			LagrangianBound bound( instance, k );
+			bound.setThreads( threads > 0 ? threads : Tools::availableCores() );
+			bound.solve( start.isValid() ? start.weight : -1 );
+			bound.getEdgeBounds( fixingBounds );
+			fixingIncumbent = -1;
+		}
+	}
 
-		for (unsigned int i=0; i<edges.getSize(); i++) {
+	// solve model
+	cout << "Calling " << backendName << " solve ...\n";
+	rootEnd = -1;
+	repairNextNode = repairRuns = 0;
+	repairTime = 0;
+	double solveStart = Tools::wallTime();
+	progressLog.start();
+	bool feasible = backend->solve();
+	double solveEnd = Tools::wallTime();
+	cout << backendName << " finished.\n\n";
+
+	progressLog.finish(backend->getNodes(), feasible, feasible ? backend->getObjectiveValue() : 0,
+			backend->getBestBound(), backend->getCuts());
+
+	// solved within the root node if the callback never saw a processed node
+	if (rootEnd < 0) {
+		rootEnd = solveEnd;
+	}
+	timings.rootLP = rootEnd - solveStart;
+	timings.branchAndBound = solveEnd - rootEnd;
+
+	nodes = backend->getNodes();
+	optimal = backend->isOptimal();
+	if (!feasible) {
+		// e.g. the tree limit was hit or the solve was aborted before any solution was found
+		cout << "Solver status: " << backend->getStatus() << ", no solution\n";
+		objectiveValue = 0;
+		solution = KTree();
+		return;
+	}
+	objectiveValue = backend->getObjectiveValue();
 
-			edgeLabels << " " << instance.edges[i % instance.n_edges].v1 << instance.edges[i % instance.n_edges].v2;
+	cout << "Solver status: " << backend->getStatus() << "\n";
+	cout << "Branch-and-Bound nodes: " << nodes << "\n";
+	if (nodeFixing) {
+		cout << "Node fixing: " << progressLog.getFixedVariables() << " variables against the final incumbent, "
+				<< progressLog.getFixingNodes() << " nodes\n";
+	}
+	if (repairFrequency > 0) {
+		cout << "LP repair: " << repairRuns << " runs, " << repairTime << "s\n";
+	}
+	cout << "Objective value: " << objectiveValue  << "\n";
+	cout << "CPU time: " << Tools::CPUtime() << "\n\n";
 
-			// skip unused ones
-			if (((int)edgesSelected[i])  == 0 ) {
-				continue;
-			}
+	// show result, values of the edges and vertices (flows and u only for the output)
+	vector<double> values(columns, 0);
+	for (unsigned int i=0; i<edges.size(); i++) {
+		values[ edges[i] ] = backend->getValue(edges[i]);
+	}
+	for (unsigned int i=0; i<vertices.size(); i++) {
+		values[ vertices[i] ] = backend->getValue(vertices[i]);
+	}
+	solution = valuesToTree(values);
+	if (shared != NULL) {
+		shared->offer(solution);
+	}
 
-			if (i == instance.n_edges) {
-				cout << endl;
-			}
-			bool direction = ( i >= instance.n_edges);
-			cout << "  " << setw(4) <<  i << ": " << ((int)edgesSelected[i]) << " ";
-
-			// flow
-			if (model_type == "scf") {
-				cout << "f: " << setw(2) << (flowRes[i]);
-			} else if (model_type == "mtz") {
-				if (uRes.getSize() != 0) {
-					cout << "u: " ;
-					if (i < instance.n_edges) {
-						//cout << setw(2) << instance.edges[i % instance.n_edges].v1 << ": ";
-						cout << setw(2) <<((int)uRes[ instance.edges[i % instance.n_edges].v1]) << " ";
-						//cout << setw(2) << instance.edges[i % instance.n_edges].v2 << ": ";
-						cout << setw(2) << ((int)uRes[ instance.edges[i % instance.n_edges].v2]) ;
-					}  else {
-						//cout << setw(2) << instance.edges[i % instance.n_edges].v2 << ": ";
-						cout << setw(2) <<((int)uRes[ instance.edges[i % instance.n_edges].v2]) << " ";
-						//cout << setw(2) << instance.edges[i % instance.n_edges].v1 << ": ";
-						cout << setw(2) <<((int)uRes[ instance.edges[i % instance.n_edges].v1]) ;
-					}
-				}
-			} else if (model_type == "mcf") {
+	if (DO_LOGGING) {
+	for (unsigned int i=0; i<flow_scf.size(); i++) {
+		values[ flow_scf[i] ] = backend->getValue(flow_scf[i]);
+	}
+	for (unsigned int i=0; i<u.size(); i++) {
+		values[ u[i] ] = backend->getValue(u[i]);
+	}
 
-			}
+	cout << "Edges:\n";
 
-			cout << " " << Tools::edgeToString(instance.edges[i % instance.n_edges], direction) ;
+	stringstream edgeLabels; // for debug output MCF
+	edgeLabels << "EDGE";
 
+	Tools::Tree tree(instance.n_nodes);
 
-			cout << endl;
+	for (unsigned int i=0; i<edges.size(); i++) {
 
+		edgeLabels << " " << instance.edges[i % instance.n_edges].v1 << instance.edges[i % instance.n_edges].v2;
 
-			if (model_type == "scf") { // build tree
-				if (!direction) {
-					tree.addEdge( instance.edges[i % instance.n_edges].v1,
-												instance.edges[i % instance.n_edges].v2,
-												flowRes[i] );
-				} else {
-					tree.addEdge( instance.edges[i % instance.n_edges].v2,
-												instance.edges[i % instance.n_edges].v1,
-												flowRes[i] );
-				}
-			}
+		// skip unused ones
+		if (((int)values[ edges[i] ])  == 0 ) {
+			continue;
 		}
-		if (false) {
-			cout << "\nscf-tree: \n";
-			tree.print(cout);
+
+		if (i == instance.n_edges) {
+			cout << endl;
 		}
+		bool direction = ( i >= instance.n_edges);
+		cout << "  " << setw(4) <<  i << ": " << ((int)values[ edges[i] ]) << " ";
 
-			if (model_type == "mtz") {
-				cout << " U  Values\r\n";
-				for (int i=0; i<uRes.getSize(); i++) {
-					cout << " U["<< i <<"] = " << (int)uRes[i] << "\r\n";
-				}  
+		// flow
+		if (model_type == "scf") {
+			cout << "f: " << setw(2) << (values[ flow_scf[i] ]);
+		} else if (model_type == "mtz") {
+			cout << "u: " ;
+			if (i < instance.n_edges) {
+				cout << setw(2) <<((int)values[ u[ instance.edges[i % instance.n_edges].v1 ] ]) << " ";
+				cout << setw(2) << ((int)values[ u[ instance.edges[i % instance.n_edges].v2 ] ]) ;
+			}  else {
+				cout << setw(2) <<((int)values[ u[ instance.edges[i % instance.n_edges].v2 ] ]) << " ";
+				cout << setw(2) <<((int)values[ u[ instance.edges[i % instance.n_edges].v1 ] ]) ;
 			}
-		}// do logging
+		} else if (model_type == "mcf") {
+
+		}
 
+		cout << " " << Tools::edgeToString(instance.edges[i % instance.n_edges], direction) ;
 
 
+		cout << endl;
 
 
-	} catch (IloAlgorithm::CannotExtractException& e) {
-		cerr << "CannotExtractException: " << e << endl ;
-		IloExtractableArray failed = e.getExtractables();
-		for (IloInt i = 0; i < failed.getSize(); ++i) {
-			cerr << "\t" << failed[i] << std::endl;
+		if (model_type == "scf") { // build tree
+			if (!direction) {
+				tree.addEdge( instance.edges[i % instance.n_edges].v1,
+											instance.edges[i % instance.n_edges].v2,
+											values[ flow_scf[i] ] );
+			} else {
+				tree.addEdge( instance.edges[i % instance.n_edges].v2,
+											instance.edges[i % instance.n_edges].v1,
+											values[ flow_scf[i] ] );
+			}
 		}
-	} catch( IloException& e ) {
-		cerr << "kMST_ILP: exception " << e << "\n";
-		exit( -1 );
 	}
-	catch( ... ) {
-		cerr << "kMST_ILP: unknown exception.\n";
-		exit( -1 );
+	if (false) {
+		cout << "\nscf-tree: \n";
+		tree.print(cout);
 	}
+
+		if (model_type == "mtz") {
+			cout << " U  Values\r\n";
+			for (unsigned int i=0; i<u.size(); i++) {
+				cout << " U["<< i <<"] = " << (int)values[ u[i] ] << "\r\n";
+			}
+		}
+	}// do logging
 }
 
 // getter Methodss
@@ -169,168 +446,696 @@ int kMST_ILP::getNodes() {
 	return nodes;
 }
 
+const KTree& kMST_ILP::getTree() {
+	return solution;
+}
+
+bool kMST_ILP::isOptimal() {
+	return optimal;
+}
+
+const kMST_ILP::Timings& kMST_ILP::getTimings() {
+	return timings;
+}
+
+const ProgressLog& kMST_ILP::getProgress() {
+	return progressLog;
+}
+
+void kMST_ILP::setBackend( string name )
+{
+	backendName = name;
+}
+
+bool kMST_ILP::isSupported( string model_type, string backend )
+{
+	bool needsCallbacks = (model_type == "dcc" || model_type == "gsec" || model_type == "mcf-lean");
+	return !needsCallbacks ||
+			(MILPBackend::supportedHooks(backend.empty() ? MILPBackend::defaultName() : backend) & MILPBackend::LAZY) != 0;
+}
+
+void kMST_ILP::setProgressInterval( double seconds )
+{
+	progressLog.setInterval( seconds );
+}
+
+void kMST_ILP::setProgressTarget( double target )
+{
+	progressLog.setTarget( target );
+}
+
+void kMST_ILP::setWarmStart( const KTree& tree )
+{
+	warmStart = tree;
+}
+
+void kMST_ILP::setK( int _k )
+{
+	k = (_k == 0) ? n - 1 : _k;
+	if (!built) {
+		return; // built with this k later on
+	}
+	if (mcfLean) {
+		cerr << "mcf-lean excludes vertices for the k it was built with, it can't change k\n";
+		exit( -1 );
+	}
+
+	for (unsigned int i=0; i<kRanges.size(); i++) {
+		backend->setRowBounds(kRanges[i].row, kRanges[i].lbConstant + kRanges[i].lbPerK * k,
+				kRanges[i].ubConstant + kRanges[i].ubPerK * k);
+	}
+	for (unsigned int i=0; i<kCoefficients.size(); i++) {
+		backend->setCoefficient(kCoefficients[i].row, kCoefficients[i].column,
+				kCoefficients[i].constant + kCoefficients[i].perK * k);
+	}
+	for (unsigned int i=0; i<kUpperBounds.size(); i++) {
+		backend->setBounds(kUpperBounds[i].column, kUpperBounds[i].lb, kUpperBounds[i].constant + kUpperBounds[i].perK * k);
+	}
+	if (uSumLimit >= 0) {
+		backend->setRowBounds(uSumLimit, -MILPBackend::INF, (k * (k+1)) / 2);
+	}
+}
+
 double kMST_ILP::getObjectiveValue() {
 	return objectiveValue;
 }
 
+void kMST_ILP::setExcludedEdges( const vector<bool>& _excludedEdges )
+{
+	excludedEdges = _excludedEdges;
+}
+
+void kMST_ILP::setThreads( u_int _threads )
+{
+	threads = _threads;
+}
+
+void kMST_ILP::setParallelMode( int mode )
+{
+	parallelMode = mode;
+}
+
+int kMST_ILP::parseParallelMode( string name )
+{
+	if (name == "opportunistic") {
+		return MILPBackend::OPPORTUNISTIC;
+	} else if (name == "auto") {
+		return MILPBackend::AUTO_PARALLEL;
+	} else if (name == "deterministic") {
+		return MILPBackend::DETERMINISTIC;
+	}
+	cerr << "unknown parallel mode " << name << "\n";
+	exit( -1 );
+}
+
+void kMST_ILP::setMemoryLimits( double _workMemory, double _treeMemory )
+{
+	workMemory = _workMemory;
+	treeMemory = _treeMemory;
+}
+
+void kMST_ILP::setTimeLimit( double seconds )
+{
+	timeLimit = seconds;
+}
+
+void kMST_ILP::setVariableNames( bool _names )
+{
+	names = _names;
+}
+
+void kMST_ILP::setNodeFixing( bool _nodeFixing )
+{
+	nodeFixing = _nodeFixing;
+}
+
+void kMST_ILP::setVertexBranching( bool _vertexBranching )
+{
+	vertexBranching = _vertexBranching;
+}
+
+void kMST_ILP::setLPRepair( int frequency, double budget )
+{
+	repairFrequency = frequency;
+	repairBudget = budget;
+}
+
+void kMST_ILP::setSharedIncumbent( SharedIncumbent* _shared )
+{
+	shared = _shared;
+}
+
+void kMST_ILP::getFixingCandidates( double incumbent, vector<u_int>& candidates )
+{
+	pthread_mutex_lock(&fixingMutex);
+	if (incumbent != fixingIncumbent) {
+		fixingIncumbent = incumbent;
+		fixingCandidates.clear();
+		fixingSeen.assign(edges.size() + instance.n_nodes, false);
+
+		// integral weights: an improving solution costs at most incumbent - 1
+		vector<bool> fixable(instance.n_edges, false);
+		for (u_int e=0; e<instance.n_edges && e<fixingBounds.size(); e++) {
+			fixable[e] = ceil(fixingBounds[e] - 1e-6) > incumbent - 0.5;
+		}
+		for (u_int arc=0; arc<edges.size(); arc++) {
+			if (fixable[arc % instance.n_edges]) {
+				fixingCandidates.push_back(arc);
+			}
+		}
+
+		// vertices without a real edge left can't be part of a tree with k > 1
+		if (hasVertexVariables() && k > 1) {
+			for (u_int v=1; v<instance.n_nodes; v++) {
+				bool hasEdge = false;
+				for (const u_int* iter = instance.incidentEdges(v).begin();
+						 iter != instance.incidentEdges(v).end(); ++iter) {
+					const Instance::Edge & edge = instance.edges[*iter];
+					hasEdge = hasEdge || (edge.v1 != 0 && edge.v2 != 0 && !fixable[*iter]);
+				}
+				if (!hasEdge) {
+					fixingCandidates.push_back(edges.size() + v);
+				}
+			}
+		}
+	}
+	candidates = fixingCandidates;
+	pthread_mutex_unlock(&fixingMutex);
+}
+
+int kMST_ILP::getFixingColumn( u_int candidate ) const
+{
+	if (candidate < edges.size()) {
+		return edges[candidate];
+	}
+	return vertices[candidate - edges.size()];
+}
+
+void kMST_ILP::addFixingCompanions( u_int candidate, vector<int>& columns ) const
+{
+	if (candidate >= edges.size()) {
+		return;
+	}
+	if (model_type == "scf") {
+		columns.push_back(flow_scf[candidate]);
+	} else if (model_type == "mcf" && mcfLayout.arcPosition[candidate] >= 0) {
+		for (unsigned int c=0; c<flow_mcf.size(); c++) {
+			if (!flow_mcf[c].empty()) {
+				columns.push_back(flow_mcf[c][ mcfLayout.arcPosition[candidate] ]);
+			}
+		}
+	}
+}
+
+void kMST_ILP::recordFixing( double incumbent, const vector<u_int>& fixed )
+{
+	pthread_mutex_lock(&fixingMutex);
+	// fixings against an older incumbent are counted with it already
+	if (incumbent == fixingIncumbent) {
+		int newVariables = 0;
+		for (unsigned int i=0; i<fixed.size(); i++) {
+			if (!fixingSeen[ fixed[i] ]) {
+				fixingSeen[ fixed[i] ] = true;
+				newVariables++;
+			}
+		}
+		progressLog.recordFixing( incumbent, newVariables );
+	}
+	pthread_mutex_unlock(&fixingMutex);
+}
+
+bool kMST_ILP::isRepairDue( int nodes )
+{
+	pthread_mutex_lock(&repairMutex);
+	bool due = nodes >= repairNextNode && (repairBudget <= 0 || repairTime < repairBudget);
+	if (due) {
+		repairNextNode = nodes + repairFrequency;
+	}
+	pthread_mutex_unlock(&repairMutex);
+	return due;
+}
+
+KTree kMST_ILP::repairTree( const vector<double>& edgeValues )
+{
+	double start = Tools::wallTime();
+
+	// both directions of an edge, gsec is undirected already
+	vector<double> values(instance.n_edges, 0);
+	for (unsigned int i=0; i<edgeValues.size(); i++) {
+		values[i % instance.n_edges] += edgeValues[i];
+	}
+	KTreeHeuristic heuristic(instance, k);
+	KTree tree = heuristic.repair(values);
+
+	pthread_mutex_lock(&repairMutex);
+	repairRuns++;
+	repairTime += Tools::wallTime() - start;
+	pthread_mutex_unlock(&repairMutex);
+	return tree;
+}
+
+bool kMST_ILP::pollSharedIncumbent( KTree& tree )
+{
+	return shared != NULL && shared->poll(sharedVersion, tree);
+}
+
+void kMST_ILP::abort()
+{
+	pthread_mutex_lock(&abortMutex);
+	aborted = true;
+	if (backend != NULL) {
+		backend->abort();
+	}
+	pthread_mutex_unlock(&abortMutex);
+}
+
+void kMST_ILP::addMIPStart( const KTree& tree )
+{
+	MILPBackend::Expr start;
+	treeToValues(tree, start);
+	if (!start.columns.empty()) {
+		backend->addMIPStart(start);
+	}
+}
+
 
 
 // ----- private methods -----------------------------------------------
 
-void kMST_ILP::setCPLEXParameters()
+bool kMST_ILP::hasVertexVariables() const
+{
+	return model_type == "dcc" || model_type == "gsec" || rootSymmetry || vertexBranching;
+}
+
+int kMST_ILP::getHooks() const
+{
+	int hooks = MILPBackend::PROGRESS;
+	// connectivity of cut models and flow <= edge of mcf-lean are enforced on the fly
+	if (model_type == "dcc" || model_type == "gsec" || mcfLean) {
+		hooks |= MILPBackend::LAZY | MILPBackend::USER_CUTS;
+	}
+	if (nodeFixing || vertexBranching) {
+		hooks |= MILPBackend::BRANCH;
+	}
+	if (repairFrequency > 0 || shared != NULL) {
+		hooks |= MILPBackend::HEURISTIC;
+	}
+	if (shared != NULL) {
+		hooks |= MILPBackend::INCUMBENT;
+	}
+	return hooks;
+}
+
+void kMST_ILP::setParameters()
 {
-	// print every x-th line of node-log and give more details
-	cplex.setParam( IloCplex::MIPInterval, 1 );
-	cplex.setParam( IloCplex::MIPDisplay, 2 );
-	// only use a single thread
-	cplex.setParam( IloCplex::Threads, 1 );
+	// only use a single thread unless a budget is given
+	backend->setThreads( threads );
+	backend->setParallelMode( parallelMode );
+	backend->setMemoryLimits( workMemory, treeMemory );
+	backend->setTimeLimit( timeLimit );
+	backend->setLogging( DO_LOGGING );
 }
 
 
 
 // ----- private utility -----------------------------------------------
-void kMST_ILP::getOutgoingEdgeIds(vector<u_int> & outgoingEdgeIds, u_int vertex)
+
+int kMST_ILP::addColumn( double lb, double ub, double cost, MILPBackend::VarType type, const string& name )
 {
-	getVertexEdgeIds(outgoingEdgeIds, vertex, /*outgoing=*/true);
+	columns++;
+	return backend->addColumn(lb, ub, cost, type, name);
+}
+
+int kMST_ILP::addKRange( const MILPBackend::Expr& expr, double lbConstant, double lbPerK,
+		double ubConstant, double ubPerK )
+{
+	int row = backend->addRow(expr, lbConstant + lbPerK * k, ubConstant + ubPerK * k);
+
+	KRange kRange = { row, lbConstant, lbPerK, ubConstant, ubPerK };
+	kRanges.push_back(kRange);
+	return row;
 }
 
-void kMST_ILP::getIncomingEdgeIds(vector<u_int> & incomingEdgeIds, u_int vertex)
+// the coefficient of the column in the row must already have its value for the current k
+void kMST_ILP::addKCoefficient( int row, int column, double constant, double perK )
 {
-	getVertexEdgeIds(incomingEdgeIds, vertex, /*outgoing=*/false);
+	KCoefficient kCoefficient = { row, column, constant, perK };
+	kCoefficients.push_back(kCoefficient);
+}
+
+void kMST_ILP::addKUpperBound( int column, double lb, double constant, double perK )
+{
+	backend->setBounds(column, lb, constant + perK * k);
+
+	KUpperBound kUpperBound = { column, lb, constant, perK };
+	kUpperBounds.push_back(kUpperBound);
+}
+
+// tree of a solution, edges are real ones only as in KTree
+KTree kMST_ILP::valuesToTree( const vector<double>& values ) const
+{
+	KTree solution;
+	solution.weight = 0;
+
+	vector<bool> inTree(instance.n_nodes, false);
+	for (unsigned int i=0; i<edges.size(); i++) {
+		if (values[ edges[i] ] < 0.5) {
+			continue;
+		}
+		const Instance::Edge & edge = instance.edges[i % instance.n_edges];
+		inTree[edge.v1] = inTree[edge.v2] = true;
+		if (edge.v1 != 0 && edge.v2 != 0) {
+			solution.edges.push_back(i % instance.n_edges);
+			solution.weight += edge.weight;
+		}
+	}
+	// single vertex trees of the cut models have no edge
+	if (model_type == "dcc" || model_type == "gsec") {
+		for (unsigned int v=0; v<vertices.size(); v++) {
+			inTree[v] = inTree[v] || values[ vertices[v] ] > 0.5;
+		}
+	}
+
+	for (u_int v=1; v<instance.n_nodes; v++) {
+		if (inTree[v]) {
+			solution.vertices.push_back(v);
+		}
+	}
+	// without the artificial root vertex 0 is an ordinary one
+	if (inTree[0] && instance.incidentEdges(0).empty()) {
+		solution.vertices.push_back(0);
+	}
+	return solution;
 }
 
-void kMST_ILP::getVertexEdgeIds(vector<u_int> & edgeIds, u_int vertex, bool outgoing)
+// values of all model variables for the given tree
+void kMST_ILP::treeToValues( const KTree& tree, MILPBackend::Expr& values )
 {
-	const list<u_int> incidences = instance.incidentEdges[vertex];
+	// root edge per vertex, if the instance has the artificial root
+	vector<int> rootEdge(instance.n_nodes, -1);
+	for (const u_int* iter = instance.incidentEdges(0).begin();
+			 iter != instance.incidentEdges(0).end(); ++iter) {
+		const Instance::Edge & edge = instance.edges[*iter];
+		rootEdge[ edge.v1 == 0 ? edge.v2 : edge.v1 ] = *iter;
+	}
+	bool hasRoot = !instance.incidentEdges(0).empty();
 
-	edgeIds.resize(incidences.size());
+	vector<vector<u_int> > treeEdges(instance.n_nodes);
+	for (unsigned int i=0; i<tree.edges.size(); i++) {
+		treeEdges[ instance.edges[ tree.edges[i] ].v1 ].push_back(tree.edges[i]);
+		treeEdges[ instance.edges[ tree.edges[i] ].v2 ].push_back(tree.edges[i]);
+	}
 
-	int i = -1;
+	// the tree is entered from 0 at its smallest vertex with a root edge (required by root symmetry breaking)
+	u_int start = tree.vertices[0];
+	for (unsigned int i=0; i<tree.vertices.size(); i++) {
+		if (rootEdge[ tree.vertices[i] ] >= 0 && (rootEdge[start] < 0 || tree.vertices[i] < start)) {
+			start = tree.vertices[i];
+		}
+	}
+	if (hasRoot && rootEdge[start] < 0) {
+		cerr << "Tree can't be connected to the artificial root\n";
+		return;
+	}
+
+	// orient all edges away from start (bfs), incoming arc per vertex in the doubled layout
+	vector<int> incomingArc(instance.n_nodes, -1), parent(instance.n_nodes, -1), depth(instance.n_nodes, 0);
+	vector<u_int> order;
+	order.push_back(start);
+	parent[start] = 0;
+	depth[start] = 1;
+	if (hasRoot) {
+		incomingArc[start] = (instance.edges[ rootEdge[start] ].v1 == 0) ? rootEdge[start] : rootEdge[start] + instance.n_edges;
+	}
+	for (unsigned int i=0; i<order.size(); i++) {
+		u_int vertex = order[i];
+		for (unsigned int j=0; j<treeEdges[vertex].size(); j++) {
+			u_int edgeId = treeEdges[vertex][j];
+			const Instance::Edge & edge = instance.edges[edgeId];
+			u_int other = (edge.v1 == vertex) ? edge.v2 : edge.v1;
+			if (other == start || parent[other] >= 0) {
+				continue;
+			}
+			parent[other] = vertex;
+			depth[other] = depth[vertex] + 1;
+			incomingArc[other] = (edge.v1 == vertex) ? edgeId : edgeId + instance.n_edges;
+			order.push_back(other);
+		}
+	}
 
-	for (list<u_int>::const_iterator iter = incidences.begin();
-			 iter != incidences.end(); ++iter) {
-		i++;
+	// arcs resp. edges
+	vector<double> edgeValues(edges.size(), 0);
+	for (unsigned int i=0; i<order.size(); i++) {
+		int arc = incomingArc[ order[i] ];
+		if (arc >= 0) {
+			edgeValues[ (model_type == "gsec") ? arc % instance.n_edges : arc ] = 1;
+		}
+	}
+	for (unsigned int i=0; i<edgeValues.size(); i++) {
+		values.add(edges[i], edgeValues[i]);
+	}
 
-	unsigned int edgeId = *iter;
-	const Instance::Edge & edge = instance.edges[edgeId];
+	for (unsigned int i=0; i<vertices.size(); i++) {
+		values.add(vertices[i], ((i == 0 && hasRoot) || parent[i] >= 0) ? 1 : 0);
+	}
+	for (unsigned int i=0; i<rootPrefix.size(); i++) {
+		values.add(rootPrefix[i], (i >= start) ? 1 : 0);
+	}
 
-	if ( (outgoing && edge.v1 == vertex ) || (!outgoing && edge.v2 == vertex) ) {
-		edgeIds[i] = edgeId;
-	} else {
-		edgeIds[i] = edgeId + instance.n_edges;
+	if (model_type == "scf") {
+		// each arc carries one token per vertex below it
+		vector<int> subtreeSize(instance.n_nodes, 0);
+		for (int i=order.size()-1; i>=0; i--) {
+			subtreeSize[ order[i] ] += 1;
+			if (order[i] != start) {
+				subtreeSize[ parent[ order[i] ] ] += subtreeSize[ order[i] ];
+			}
+		}
+		vector<double> flowValues(flow_scf.size(), 0);
+		for (unsigned int i=0; i<order.size(); i++) {
+			if (incomingArc[ order[i] ] >= 0) {
+				flowValues[ incomingArc[ order[i] ] ] = subtreeSize[ order[i] ];
+			}
+		}
+		for (unsigned int i=0; i<flowValues.size(); i++) {
+			values.add(flow_scf[i], flowValues[i]);
+		}
+	} else if (model_type == "mtz") {
+		// depth below the artificial root, vertices outside keep their lower bound
+		for (unsigned int i=0; i<u.size(); i++) {
+			bool inTree = (parent[i] >= 0);
+			values.add(u[i], inTree ? depth[i] : (i > 0 ? uMin : 0));
+		}
+	} else if (model_type == "mcf") {
+		// commodity c travels along the tree path from 0 to c
+		for (unsigned int commodity=0; commodity<flow_mcf.size(); commodity++) {
+			vector<double> flowValues(flow_mcf[commodity].size(), 0);
+			if (!flowValues.empty() && parent[commodity] >= 0) {
+				for (int vertex=commodity; ; vertex=parent[vertex]) {
+					if (incomingArc[vertex] >= 0 && mcfLayout.arcPosition[ incomingArc[vertex] ] >= 0) {
+						flowValues[ mcfLayout.arcPosition[ incomingArc[vertex] ] ] = 1;
+					}
+					if ((u_int)vertex == start) {
+						break;
+					}
+				}
+			}
+			for (unsigned int i=0; i<flowValues.size(); i++) {
+				values.add(flow_mcf[commodity][i], flowValues[i]);
+			}
+		}
 	}
-			 }
 }
 
-
-void kMST_ILP::addObjectiveFunction()
+void kMST_ILP::applyExclusions()
 {
-	// multiply variable by cost
-	IloIntArray edgeCost(env, instance.n_edges * 2);
+	if (excludedEdges.empty()) {
+		return;
+	}
+
+	int excluded = 0;
+	for (unsigned int i=0; i<edges.size(); i++) {
+		if (excludedEdges[i % instance.n_edges]) {
+			backend->setBounds(edges[i], 0, 0);
+			excluded++;
+		}
+	}
 
-	for (unsigned int i=0; i<edges.getSize(); i++) {
-		edgeCost[i] = instance.edges[i % instance.n_edges].weight;
+	// vertices without any edge left can't be selected either
+	if (model_type == "dcc" || model_type == "gsec") {
+		for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
+			bool hasEdge = false;
+			for (const u_int* iter = instance.incidentEdges(vertex).begin();
+					 iter != instance.incidentEdges(vertex).end(); ++iter) {
+				hasEdge = hasEdge || !excludedEdges[*iter];
+			}
+			if (!hasEdge) {
+				backend->setBounds(vertices[vertex], 0, 0);
+			}
+		}
 	}
 
-	model.add(IloMinimize(env,  IloScalProd(edges, edgeCost) ));
+	cout << "Excluded variables: " << excluded << " of " << edges.size() << "\n";
 }
 
+// the edge columns carry the objective: their weight
 void kMST_ILP::addTreeConstraints()
 {
-	edges = IloBoolVarArray(env, instance.n_edges * 2); // edges in one direction and in other
+	edges.resize(instance.n_edges * 2); // edges in one direction and in other
 
 	// "to"-edges on lower indices
 	for (unsigned int i=0; i<instance.n_edges; i++) {
-		edges[i] = IloBoolVar(env, Tools::indicesToString("edge " , instance.edges[i].v1, instance.edges[i].v2, instance.edges[i].weight).c_str() );
-		//cerr << "init: edge " << i << " from " << instance.edges[i].v1 << " to " << instance.edges[i].v2 << endl;
+		const Instance::Edge & edgeInst = instance.edges[i];
+		edges[i] = addColumn(0, 1, edgeInst.weight, MILPBackend::BINARY,
+				names ? Tools::indicesToString("edge " , edgeInst.v1, edgeInst.v2, edgeInst.weight) : "");
 	}
 
 	// edges in other direction
 	for (unsigned int i=instance.n_edges; i<instance.n_edges*2; i++) {
-		Instance::Edge edgeInst = instance.edges[ i % instance.n_edges ];
-		edges[i] = IloBoolVar(env, Tools::indicesToString("edge " , edgeInst.v2, edgeInst.v1, edgeInst.weight).c_str() );
-		//cerr << "init: edge " << i << " from " << instance.edges[i%instance.n_edges].v2 << " to " << instance.edges[i%instance.n_edges].v1 << endl;
+		const Instance::Edge & edgeInst = instance.edges[ i % instance.n_edges ];
+		edges[i] = addColumn(0, 1, edgeInst.weight, MILPBackend::BINARY,
+				names ? Tools::indicesToString("edge " , edgeInst.v2, edgeInst.v1, edgeInst.weight) : "");
 	}
 
 	// edges in one direction forbid edges in other direction
 	for (unsigned int i=0; i<instance.n_edges; i++) {
-		model.add( edges[i] + edges[i + instance.n_edges] <= 1 );
+		MILPBackend::Expr bothDirections;
+		bothDirections.add(edges[i], 1);
+		bothDirections.add(edges[i + instance.n_edges], 1);
+		backend->addRow(bothDirections, -MILPBackend::INF, 1);
 	}
 
 	// exactly k nodes, so k-1 actual edges plus one to the pseudo node 0
-	model.add(IloSum(edges) == k);
+	{
+		MILPBackend::Expr edgeSum;
+		for (unsigned int i=0; i<edges.size(); i++) {
+			edgeSum.add(edges[i], 1);
+		}
+		addKRange(edgeSum, 0, 1, 0, 1);
+	}
 
 	// no 2 incoming edges per vertex
 	for (unsigned int i=0; i < instance.n_nodes; i++ ){
 
-		IloExpr incomingSum(env);
-
+		Instance::Span incomingEdgeIds = instance.incomingArcs(i);
 		{
-			vector<u_int> incomingEdgeIds;
-			getIncomingEdgeIds(incomingEdgeIds, i);
-
-
-			for (unsigned int i=0; i < incomingEdgeIds.size(); i++ ){
-				incomingSum += edges[incomingEdgeIds[i]];
+			MILPBackend::Expr incomingSum;
+			for (unsigned int j=0; j < incomingEdgeIds.size(); j++ ){
+				incomingSum.add(edges[incomingEdgeIds[j]], 1);
 			}
+			backend->addRow(incomingSum, -MILPBackend::INF, 1);
 		}
 
-		model.add(incomingSum <= 1);
-
 
 		#ifdef STRENGTHEN_CONSTRAINTS
 		// only allow outgoing edges in case there are incoming ones (needs scaling by k)
-		IloExpr outgoingSum(env);
-
-		{
-			vector<u_int> outgoingEdges;
-			getOutgoingEdgeIds(outgoingEdges, i);
-
-			for (unsigned int i=0; i<outgoingEdges.size(); i++) {
-				outgoingSum += edges[outgoingEdges[i]];
+		if (i != 0) {
+			// incomingSum*(k-1) - outgoingSum >= 0
+			MILPBackend::Expr scaled;
+			for (unsigned int j=0; j<incomingEdgeIds.size(); j++) {
+				scaled.add(edges[incomingEdgeIds[j]], k - 1);
 			}
-		}
+			Instance::Span outgoingEdges = instance.outgoingArcs(i);
+			for (unsigned int j=0; j<outgoingEdges.size(); j++) {
+				scaled.add(edges[outgoingEdges[j]], -1);
+			}
+			int row = addKRange(scaled, 0, 0, MILPBackend::INF, 0);
 
-		if (i != 0) {
-			model.add(incomingSum*(k-1) >= outgoingSum);
+			for (unsigned int j=0; j<incomingEdgeIds.size(); j++) {
+				addKCoefficient(row, edges[incomingEdgeIds[j]], -1, 1);
+			}
 		}
-		outgoingSum.end();
 		#endif
-
-		incomingSum.end();
 	}
 
 	// only 1 outgoing node from 0
 	{
-		IloExpr outgoingSum(env);
-
-		bool hasOutgoing = false;
-		{
-			vector<u_int> outgoingEdges;
-			getOutgoingEdgeIds(outgoingEdges, 0);
+		Instance::Span outgoingEdges = instance.outgoingArcs(0);
 
-			for (unsigned int i=0; i<outgoingEdges.size(); i++) {
-				hasOutgoing = true;
-				outgoingSum += edges[outgoingEdges[i]];
-			}
+		MILPBackend::Expr outgoingSum;
+		for (unsigned int i=0; i<outgoingEdges.size(); i++) {
+			outgoingSum.add(edges[outgoingEdges[i]], 1);
 		}
 
-		if (hasOutgoing) { // only true for special input files
-			model.add(outgoingSum == 1);
+		if (!outgoingEdges.empty()) { // only false for special input files
+			backend->addRow(outgoingSum, 1, 1);
 		}
-		outgoingSum.end();
 	}
 
 
 	// no incoming to 0
 	{
-		vector<u_int> incomingEdges;
-		getIncomingEdgeIds(incomingEdges, 0);
+		Instance::Span incomingEdges = instance.incomingArcs(0);
 
 		for (unsigned int i=0; i<incomingEdges.size(); i++) {
-			model.add( edges[incomingEdges[i]] == 0) ;
+			MILPBackend::Expr incoming;
+			incoming.add(edges[incomingEdges[i]], 1);
+			backend->addRow(incoming, 0, 0);
+		}
+
+	}
+}
+
+// y_v = sum of the arcs into v for the compact models, 1 iff v is part of the tree
+void kMST_ILP::addVertexVariables()
+{
+	vertices.resize(instance.n_nodes);
+	for (unsigned int vertex=0; vertex<instance.n_nodes; vertex++) {
+		vertices[vertex] = addColumn(vertex == 0 ? 1 : 0, 1, 0, MILPBackend::BINARY,
+				names ? Tools::indicesToString("vertex", vertex) : "");
+	}
+
+	for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
+		MILPBackend::Expr entered;
+		entered.add(vertices[vertex], 1);
+		Instance::Span incomingEdgeIds = instance.incomingArcs(vertex);
+		for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+			entered.add(edges[ incomingEdgeIds[i] ], -1);
+		}
+		backend->addRow(entered, 0, 0);
+	}
+}
+
+// every selected vertex v needs the arc 0->w of some w <= v, so 0 enters the tree at its smallest vertex
+//
+// the prefix sums of the root arcs make this linear in n, they imply the pairwise x_0v + y_w <= 1 for w < v
+void kMST_ILP::addRootSymmetryBreaking()
+{
+	if (instance.outgoingArcs(0).empty()) {
+		cerr << "root symmetry breaking needs the artificial root node 0\n";
+		exit( -1 );
+	}
+
+	vector<int> rootArc(instance.n_nodes, -1);
+	{
+		Instance::Span outgoingEdgeIds = instance.outgoingArcs(0);
+		for (unsigned int i=0; i<outgoingEdgeIds.size(); i++) {
+			u_int arc = outgoingEdgeIds[i];
+			const Instance::Edge & edge = instance.edges[arc % instance.n_edges];
+			rootArc[ (arc < instance.n_edges) ? edge.v2 : edge.v1 ] = arc;
+		}
+	}
+
+	rootPrefix.resize(instance.n_nodes);
+	for (unsigned int vertex=0; vertex<instance.n_nodes; vertex++) {
+		rootPrefix[vertex] = addColumn(0, vertex == 0 ? 0 : 1, 0, MILPBackend::CONTINUOUS,
+				names ? Tools::indicesToString("rootPrefix", vertex) : "");
+	}
+
+	for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
+		// rootPrefix_v = rootPrefix_v-1 + x_0v
+		MILPBackend::Expr prefix;
+		prefix.add(rootPrefix[vertex], 1);
+		prefix.add(rootPrefix[vertex - 1], -1);
+		if (rootArc[vertex] >= 0) {
+			prefix.add(edges[ rootArc[vertex] ], -1);
 		}
+		backend->addRow(prefix, 0, 0);
 
+		MILPBackend::Expr entered;
+		entered.add(vertices[vertex], 1);
+		entered.add(rootPrefix[vertex], -1);
+		backend->addRow(entered, -MILPBackend::INF, 0);
 	}
 }
 
@@ -341,14 +1146,12 @@ void kMST_ILP::modelSCF()
 	// single commodity flow model
 
 	// flow for each edge
-	flow_scf = IloNumVarArray(env, edges.getSize()); 
-
-	for (unsigned int i=0; i<flow_scf.getSize(); i++) {
-		flow_scf[i] = IloNumVar(env, Tools::indicesToString("flow", i).c_str());
-		//flow_scf[i] = IloNumVar(env, 0, IloInfinity, IloNumVar::Int, Tools::indicesToString("flow", i).c_str());
+	flow_scf.resize(edges.size());
 
+	for (unsigned int i=0; i<flow_scf.size(); i++) {
 		// non-zero
-		model.add(0 <= flow_scf[i]);
+		flow_scf[i] = addColumn(0, MILPBackend::INF, 0, MILPBackend::CONTINUOUS,
+				names ? Tools::indicesToString("flow", i) : "");
 
 		// max possible flow is k for the connection from the artificial root to the real node
 		// the other ones then can carry a maximum of k-1, since the real root eats the first one
@@ -356,193 +1159,342 @@ void kMST_ILP::modelSCF()
 		#ifdef STRENGTHEN_CONSTRAINTS
 		bool firstHalf = ( i < instance.n_edges);
 		int startNode = firstHalf ? instance.edges[i].v1 : instance.edges[i - instance.n_edges].v2;
-		int maxFlowOnEdge = (startNode == 0) ? k : k-1;
+		int flowReduction = (startNode == 0) ? 0 : 1;
 		#else
-		int maxFlowOnEdge = k;
+		int flowReduction = 0;
 		#endif
+		int maxFlowOnEdge = k - flowReduction;
 
 		// at most k, also ensures that edge is taken if flow is non-zero
-		model.add(flow_scf[i] <= maxFlowOnEdge*edges[i]);
+		MILPBackend::Expr capacity;
+		capacity.add(flow_scf[i], 1);
+		capacity.add(edges[i], -maxFlowOnEdge);
+		int row = addKRange(capacity, -MILPBackend::INF, 0, 0, 0);
+		addKCoefficient(row, edges[i], flowReduction, -1);
 	}
 
 	// 0 emits k tokens
 	{
-		vector<u_int> outgoingEdgeIds;
-		getOutgoingEdgeIds(outgoingEdgeIds, 0);
+		Instance::Span outgoingEdgeIds = instance.outgoingArcs(0);
 
-		IloExpr outgoingFlowSum(env);
+		MILPBackend::Expr outgoingFlowSum;
 		for (unsigned int i=0; i<outgoingEdgeIds.size(); i++) {
-			outgoingFlowSum += flow_scf[ outgoingEdgeIds[i] ];
+			outgoingFlowSum.add(flow_scf[ outgoingEdgeIds[i] ], 1);
 		}
 
-		model.add(outgoingFlowSum == k);
+		addKRange(outgoingFlowSum, 0, 1, 0, 1);
 	}
 
 	// flow conservation, each node, which is taken, eats one (except first)
 	{
-		vector<u_int> outgoingEdgeIds;
-		getOutgoingEdgeIds(outgoingEdgeIds, 0);
-
 		for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
-			vector<u_int> outgoingEdgeIds, incomingEdgeIds;
-
-			getIncomingEdgeIds(incomingEdgeIds, vertex);
+			// vertex is part solution if one incoming vertex is used
+			// incomingFlowSum - outgoingFlowSum == incomingEdgesSum
+			MILPBackend::Expr conservation;
 
-			IloExpr incomingFlowSum(env);
-			IloExpr incomingEdgesSum(env);
+			Instance::Span incomingEdgeIds = instance.incomingArcs(vertex);
 			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
-				incomingFlowSum += flow_scf[ incomingEdgeIds[i] ];
-				incomingEdgesSum += edges[ incomingEdgeIds[i] ];
+				conservation.add(flow_scf[ incomingEdgeIds[i] ], 1);
+				conservation.add(edges[ incomingEdgeIds[i] ], -1);
 			}
 
-			getOutgoingEdgeIds(outgoingEdgeIds, vertex);
-			IloExpr outgoingFlowSum(env);
+			Instance::Span outgoingEdgeIds = instance.outgoingArcs(vertex);
 			for (unsigned int i=0; i<outgoingEdgeIds.size(); i++) {
-				outgoingFlowSum += flow_scf[ outgoingEdgeIds[i] ];
+				conservation.add(flow_scf[ outgoingEdgeIds[i] ], -1);
 			}
 
-			// vertex is part solution if one incoming vertex is used
-
-			model.add(incomingFlowSum - outgoingFlowSum == incomingEdgesSum);
-
-			incomingFlowSum.end();
-			incomingEdgesSum.end();
-			outgoingFlowSum.end();
+			backend->addRow(conservation, 0, 0);
 		}
 	}
 }
 
-void kMST_ILP::modelMCF()
+// commodities first, first + step, ... of the mcf rows
+struct MCFRowWorker
 {
-	//  multi commodity flow model
-
-	vector<IloBoolVarArray> flow;
-	// flow for each edge and commodity
-	flow.resize(instance.n_nodes);
-
-	for (unsigned int j=0; j<flow.size(); j++) { //  commodity j
-		flow[j] = IloBoolVarArray(env, edges.getSize());
-		for (unsigned int i=0; i<flow[j].getSize(); i++) { // edge i
-
-			Instance::Edge edgeInst = instance.edges[ i % instance.n_edges ];
+	const kMST_ILP* ilp;
+	MILPBackend::RowBlock* rows;
+	const vector<u_int>* commodities;
+	const vector<int> *rowOffset, *entryOffset; // per commodity slot
+	u_int first, step;
+};
+
+static void* runMCFRowWorker( void* argument )
+{
+	MCFRowWorker* worker = (MCFRowWorker*)argument;
+	for (u_int slot=worker->first; slot<worker->commodities->size(); slot+=worker->step) {
+		worker->ilp->fillMCFRows((*worker->commodities)[slot], *worker->rows, (*worker->rowOffset)[slot],
+				(*worker->entryOffset)[slot]);
+	}
+	return NULL;
+}
 
-			uint start = edgeInst.v1, end = edgeInst.v2;
-             		if (i >= instance.n_edges) { // upper half
-				uint tmp = start;
-				start = end;
-				end = tmp;
+// commodities and arcs which get flow variables
+//
+// mcf: every arc for every vertex but 0;
+// mcf-lean: only vertices and arcs which may be part of a solution within the heuristic upper bound
+// (Lagrangian reduced costs and exclusions), all others are fixed to 0
+void kMST_ILP::layoutMCF()
+{
+	const u_int arcs = edges.size();
+	vector<bool> arcExcluded(arcs, false);
+	mcfLayout.vertexKept.assign(instance.n_nodes, true);
+
+	if (mcfLean) {
+		LagrangianBound bound( instance, k );
+		bound.setThreads( threads > 0 ? threads : Tools::availableCores() );
+		bound.solve();
+		vector<bool> excludedEdges, excludedVertices;
+		bound.getExclusions(bound.getUpperBound(), excludedEdges, excludedVertices);
+
+		// vertices without any real edge left can't be part of a tree with k > 1
+		vector<bool> hasEdge(instance.n_nodes, false);
+		for (u_int e=0; e<instance.n_edges; e++) {
+			const Instance::Edge & edge = instance.edges[e];
+			bool excluded = excludedEdges[e] || (!this->excludedEdges.empty() && this->excludedEdges[e]);
+			if (!excluded && edge.v1 != 0 && edge.v2 != 0) {
+				hasEdge[edge.v1] = hasEdge[edge.v2] = true;
 			}
+		}
+		for (u_int v=1; v<instance.n_nodes; v++) {
+			mcfLayout.vertexKept[v] = !excludedVertices[v] && (k <= 1 || hasEdge[v]);
+		}
 
-			flow[j][i] = IloBoolVar(env, Tools::indicesToString("f", start, end).c_str());
-			
-			#ifdef STRENGTHEN_CONSTRAINTS
-			// strenghten:no flow back to root
-			if (end == 0) {
-				flow[j][i].setUB(0);
+		for (u_int arc=0; arc<arcs; arc++) {
+			u_int e = arc % instance.n_edges;
+			const Instance::Edge & edge = instance.edges[e];
+			u_int end = (arc < instance.n_edges) ? edge.v2 : edge.v1;
+			arcExcluded[arc] = excludedEdges[e] || (!this->excludedEdges.empty() && this->excludedEdges[e]) ||
+					!mcfLayout.vertexKept[edge.v1] || !mcfLayout.vertexKept[edge.v2] || end == 0;
+			if (arcExcluded[arc]) {
+				backend->setBounds(edges[arc], 0, 0);
 			}
-			#endif
-
- 		}
+		}
 	}
 
-	// preperation
-
-	IloExprArray incomingEdgesSum = IloExprArray(env, instance.n_nodes);
-
-	for (unsigned int commodity=0; commodity<flow.size(); commodity++) { //  commodity k for vertex k
-		vector<u_int> incomingEdgeIds, outgoingEdgeIds;
-		getIncomingEdgeIds(incomingEdgeIds, commodity);
-
-		incomingEdgesSum [commodity] = IloExpr(env);
-
-		for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
-			incomingEdgesSum[commodity] += edges[ incomingEdgeIds[i] ];
+	mcfLayout.arcPosition.assign(arcs, -1);
+	mcfLayout.arcs.clear();
+	for (u_int arc=0; arc<arcs; arc++) {
+		if (!arcExcluded[arc]) {
+			mcfLayout.arcPosition[arc] = mcfLayout.arcs.size();
+			mcfLayout.arcs.push_back(arc);
 		}
-
-
 	}
+	mcfLayout.keptArcs = mcfLayout.arcs.size();
 
+	mcfLayout.commoditySlot.assign(instance.n_nodes, -1);
+	int slots = 0;
+	for (u_int v=1; v<instance.n_nodes; v++) {
+		if (mcfLayout.vertexKept[v]) {
+			mcfLayout.commoditySlot[v] = slots++;
+		}
+	}
+	mcfLayout.coupling = !mcfLean;
 
-	// node 0 emits k-1 different commodities
-       // tries all n-1, but only sends to nodes with incoming edge
-	{
-		vector<u_int> outgoingEdgeIds;
-		getOutgoingEdgeIds(outgoingEdgeIds, 0);
-
-		for (unsigned int commodity=1; commodity<flow.size(); commodity++) { //  commodity k for vertex k
-			IloExpr outgoingFlowSum(env);
-			for (unsigned int i=0; i<outgoingEdgeIds.size(); i++) {
-				outgoingFlowSum += flow[ commodity ][ outgoingEdgeIds[i] ];
-			}
+	if (mcfLean) {
+		cout << "Lean mcf: " << slots << " commodities, " << mcfLayout.keptArcs << " of " << arcs << " arcs\n";
+	}
+}
 
-			// only send out commodity for those vertices
-			//that a part of the k-MST
-			model.add(outgoingFlowSum == incomingEdgesSum[commodity]);
+void kMST_ILP::modelMCF()
+{
+	//  multi commodity flow model
+	//
+	// n * 2m flow variables and as many rows, so the rows are filled into one preallocated block
+	// (commodities in parallel) and loaded at once instead of through an expression per row
 
-			outgoingFlowSum.end();
+	layoutMCF();
 
+	vector<vector<int> > flow;
+	// flow for each kept arc and commodity, none for commodity 0
+	flow.resize(instance.n_nodes);
 
- 		}
-	}
+	// the flows of all commodities follow each other in the order of the commodity slots
+	mcfLayout.firstFlow = columns;
 
-	// each vertex recieves his commodity (if part of k-MST)
-		for (unsigned int commodity=1; commodity<flow.size(); commodity++) { //  commodity k for vertex k
-			vector<u_int> incomingEdgeIds;
-			getIncomingEdgeIds(incomingEdgeIds, commodity);
-			IloExpr incomingFlowSum(env);
-			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
-				incomingFlowSum += flow[ commodity ][ incomingEdgeIds[i] ];
+	vector<u_int> commodities;
+	for (unsigned int j=0; j<flow.size(); j++) { //  commodity j
+		if (mcfLayout.commoditySlot[j] < 0) {
+			continue;
+		}
+		commodities.push_back(j);
+
+		for (int position=0; position<mcfLayout.keptArcs; position++) {
+			u_int i = mcfLayout.arcs[position]; // edge i
+			string name;
+			if (names) {
+				Instance::Edge edgeInst = instance.edges[ i % instance.n_edges ];
+				uint start = edgeInst.v1, end = edgeInst.v2;
+				if (i >= instance.n_edges) { // upper half
+					uint tmp = start;
+					start = end;
+					end = tmp;
+				}
+				name = Tools::indicesToString("f", start, end);
 			}
-
-			model.add(incomingFlowSum == incomingEdgesSum[commodity]);
-
-			incomingFlowSum.end();
+			// integral on integral edges once the flow can only use tree arcs
+			flow[j].push_back(addColumn(0, 1, 0, mcfLean ? MILPBackend::CONTINUOUS : MILPBackend::BINARY, name));
 		}
 
-
-	// each vertex forwards all other commodities
-	for (unsigned int vertex=1; vertex<flow.size(); vertex++) {
-		vector<u_int> outgoingEdgeIds, incomingEdgeIds; 
-		getIncomingEdgeIds(incomingEdgeIds, vertex); // these are different from the edges above
-		getOutgoingEdgeIds(outgoingEdgeIds, vertex);
-
-		for (unsigned int commodity=1; commodity<flow.size(); commodity++) { //  commodity k for vertex k
-
-			IloExpr incomingFlowSum(env);
-			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
-				incomingFlowSum += flow[ commodity ][ incomingEdgeIds[i] ];
+		#ifdef STRENGTHEN_CONSTRAINTS
+		// strenghten:no flow back to root
+		Instance::Span incomingEdgeIds = instance.incomingArcs(0);
+		for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+			int position = mcfLayout.arcPosition[ incomingEdgeIds[i] ];
+			if (position >= 0) {
+				backend->setBounds(flow[j][position], 0, 0);
 			}
+		}
+		#endif
+	}
 
-			IloExpr outgoingFlowSum(env);
-			for (unsigned int i=0; i<outgoingEdgeIds.size(); i++) {
-				outgoingFlowSum += flow[ commodity ][ outgoingEdgeIds[i] ];
-			}
-			if (vertex != commodity) {
-				model.add(incomingFlowSum - outgoingFlowSum == 0);
-			}
-			//incomingFlowSum.end();
-			outgoingFlowSum.end();
+	// kept arcs per vertex
+	vector<int> keptIncoming(instance.n_nodes, 0), keptOutgoing(instance.n_nodes, 0);
+	for (int position=0; position<mcfLayout.keptArcs; position++) {
+		u_int arc = mcfLayout.arcs[position];
+		const Instance::Edge & edge = instance.edges[arc % instance.n_edges];
+		bool forward = (arc < instance.n_edges);
+		keptOutgoing[forward ? edge.v1 : edge.v2]++;
+		keptIncoming[forward ? edge.v2 : edge.v1]++;
+	}
+
+	// rows and entries per commodity, so that every commodity knows its place in the block
+	int conservationRows = 0, conservationEntries = 0;
+	for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
+		if (mcfLayout.vertexKept[vertex]) {
+			conservationRows++;
+			conservationEntries += keptIncoming[vertex] + keptOutgoing[vertex];
 		}
+	}
+	int couplingRows = mcfLayout.coupling ? mcfLayout.keptArcs : 0;
+	vector<int> rowOffset(commodities.size() + 1, 0), entryOffset(commodities.size() + 1, 0);
+	for (unsigned int slot=0; slot<commodities.size(); slot++) {
+		u_int commodity = commodities[slot];
+		int incoming = keptIncoming[commodity];
+		int outgoing = keptOutgoing[commodity];
+		int rows = 2 + (conservationRows - 1) + couplingRows;
+		int entries = (keptOutgoing[0] + incoming) + 2 * incoming
+				+ (conservationEntries - incoming - outgoing) + 2 * couplingRows;
+		rowOffset[slot + 1] = rowOffset[slot] + rows;
+		entryOffset[slot + 1] = entryOffset[slot] + entries;
+	}
 
- 	}
+	MILPBackend::RowBlock rows;
+	rows.begin.resize(rowOffset.back() + 1);
+	rows.lb.resize(rowOffset.back());
+	rows.ub.resize(rowOffset.back());
+	rows.columns.resize(entryOffset.back());
+	rows.values.resize(entryOffset.back());
+	rows.begin[ rowOffset.back() ] = entryOffset.back();
+
+	u_int workers = min(threads > 0 ? threads : Tools::availableCores(), max((u_int)commodities.size(), 1u));
+	vector<MCFRowWorker> rowWorkers(workers);
+	vector<pthread_t> handles(workers);
+	for (u_int i=0; i<workers; i++) {
+		rowWorkers[i].ilp = this;
+		rowWorkers[i].rows = &rows;
+		rowWorkers[i].commodities = &commodities;
+		rowWorkers[i].rowOffset = &rowOffset;
+		rowWorkers[i].entryOffset = &entryOffset;
+		rowWorkers[i].first = i;
+		rowWorkers[i].step = workers;
+	}
+	// worker 0 runs in the calling thread
+	for (u_int i=1; i<workers; i++) {
+		pthread_create(&handles[i], NULL, runMCFRowWorker, &rowWorkers[i]);
+	}
+	runMCFRowWorker(&rowWorkers[0]);
+	for (u_int i=1; i<workers; i++) {
+		pthread_join(handles[i], NULL);
+	}
 
+	backend->addRows(rows);
 
+	// copy for former access
+	flow_mcf = flow;
 
+}
 
-	// restrict flow to selected edges
-	for (unsigned int edgeId=0; edgeId < edges.getSize(); edgeId++) {
-		for (unsigned int commodity=1; commodity<flow.size(); commodity++) { //  commodity k for vertex k
-			model.add ( flow[commodity][edgeId] <= edges[edgeId] );
+// rows of one commodity c, in this order:
+//  node 0 emits c if c is part of the tree: flow out of 0 == edges into c
+//  c receives it: flow into c == edges into c
+//  every other vertex forwards it: flow in - flow out == 0
+//  flow only on selected arcs: flow <= edge (not for mcf-lean, separated there)
+void kMST_ILP::fillMCFRows( u_int commodity, MILPBackend::RowBlock& rows, int row, int entry ) const
+{
+	const MCFLayout& layout = mcfLayout;
+	const int base = layout.firstFlow + layout.commoditySlot[commodity] * layout.keptArcs; // first flow column
+
+	Instance::Span outgoingRootIds = instance.outgoingArcs(0);
+	Instance::Span incomingEdgeIds = instance.incomingArcs(commodity);
+
+	rows.begin[row] = entry;
+	rows.lb[row] = rows.ub[row] = 0;
+	for (unsigned int i=0; i<outgoingRootIds.size(); i++) {
+		if (layout.arcPosition[ outgoingRootIds[i] ] >= 0) {
+			rows.columns[entry] = base + layout.arcPosition[ outgoingRootIds[i] ];
+			rows.values[entry++] = 1;
 		}
 	}
-
-	for (unsigned int commodity=1; commodity<flow.size(); commodity++) { //  commodity k for vertex k
-		incomingEdgesSum[commodity].end();
+	for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+		if (layout.arcPosition[ incomingEdgeIds[i] ] >= 0) {
+			rows.columns[entry] = edges[ incomingEdgeIds[i] ];
+			rows.values[entry++] = -1;
+		}
+	}
+	row++;
+
+	rows.begin[row] = entry;
+	rows.lb[row] = rows.ub[row] = 0;
+	for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+		if (layout.arcPosition[ incomingEdgeIds[i] ] >= 0) {
+			rows.columns[entry] = base + layout.arcPosition[ incomingEdgeIds[i] ];
+			rows.values[entry++] = 1;
+		}
+	}
+	for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+		if (layout.arcPosition[ incomingEdgeIds[i] ] >= 0) {
+			rows.columns[entry] = edges[ incomingEdgeIds[i] ];
+			rows.values[entry++] = -1;
+		}
 	}
+	row++;
 
-	// copy for former access
-	flow_mcf = flow;
+	for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
+		if (vertex == commodity || !layout.vertexKept[vertex]) {
+			continue;
+		}
+		Instance::Span incomingIds = instance.incomingArcs(vertex);
+		Instance::Span outgoingIds = instance.outgoingArcs(vertex);
+		rows.begin[row] = entry;
+		rows.lb[row] = rows.ub[row] = 0;
+		for (unsigned int i=0; i<incomingIds.size(); i++) {
+			if (layout.arcPosition[ incomingIds[i] ] >= 0) {
+				rows.columns[entry] = base + layout.arcPosition[ incomingIds[i] ];
+				rows.values[entry++] = 1;
+			}
+		}
+		for (unsigned int i=0; i<outgoingIds.size(); i++) {
+			if (layout.arcPosition[ outgoingIds[i] ] >= 0) {
+				rows.columns[entry] = base + layout.arcPosition[ outgoingIds[i] ];
+				rows.values[entry++] = -1;
+			}
+		}
+		row++;
+	}
 
+	if (!layout.coupling) {
+		return;
+	}
+	for (int position=0; position<layout.keptArcs; position++) {
+		rows.begin[row] = entry;
+		rows.lb[row] = -MILPBackend::INF;
+		rows.ub[row] = 0;
+		rows.columns[entry] = base + position;
+		rows.values[entry++] = 1;
+		rows.columns[entry] = edges[ layout.arcs[position] ];
+		rows.values[entry++] = -1;
+		row++;
+	}
 }
 
 
@@ -551,58 +1503,65 @@ void kMST_ILP::modelMTZ()
 	// Miller-Tucker-Zemlin model
 
 
-	IloInt u_max = k ; // version 1
-	//IloInt u_max = k * instance.n_nodes; // version 2
+	int u_max = k ; // version 1
+	//int u_max = k * instance.n_nodes; // version 2
 
 	// the uSum constraint may actually worsen runtime, so only optional
 	#define ACTIVATE_U_SUM false
 
-	// some u_i for each vertex
-	u = IloIntVarArray(env, instance.n_nodes);
-	for (unsigned int i=0; i<u.getSize(); i++) {
-		u[i] = IloIntVar(env, 0, u_max, Tools::indicesToString("u", i).c_str());
+	#ifdef STRENGTHEN_CONSTRAINTS
+	// strengthen constraints for non artificial nodes
+	uMin = ACTIVATE_U_SUM ? 0 : 1;
+	#endif
 
-		#ifdef STRENGTHEN_CONSTRAINTS
-		// strengthen constraints for non artificial nodes
-		if (!ACTIVATE_U_SUM && i > 0) {
-			u[i].setLB(1); 
+	// some u_i for each vertex, the 0 vertex has fixed value
+	u.resize(instance.n_nodes);
+	for (unsigned int i=0; i<u.size(); i++) {
+		u[i] = addColumn(0, 0, 0, MILPBackend::INTEGER, names ? Tools::indicesToString("u", i) : "");
+		if (i > 0) {
+			addKUpperBound(u[i], uMin, 0, 1); // u_max
 		}
-		#endif
 	}
 
-	// 0 vertex has fixed value
-	u[0].setUB(0);
-
 	// if there is a connection x_ij, the u_j is greater than u_i
-	for (unsigned int edgeId=0; edgeId < edges.getSize(); edgeId++) {
+	for (unsigned int edgeId=0; edgeId < edges.size(); edgeId++) {
 		Instance::Edge edgeInst = instance.edges[ edgeId % instance.n_edges ];
 
 		uint start = edgeInst.v1, end = edgeInst.v2;
-             	if (edgeId >= instance.n_edges) { // upper half
+		if (edgeId >= instance.n_edges) { // upper half
 			uint tmp = start;
 			start = end;
 			end = tmp;
 		}
 
-		//cerr << "edge " << edgeId << " from " << start << " to " << end << endl;
-
-		// u_start + edge < u_end + (1-edge) * M
-		model.add( (u[start] + edges[edgeId])  - u[end] - ( ( 1 - edges[edgeId]) * u_max )  <= 0 );
+		// u_start + edge < u_end + (1-edge) * M, i.e. u_start - u_end + (1+M) edge <= M
+		{
+			MILPBackend::Expr order;
+			order.add(u[start], 1);
+			order.add(u[end], -1);
+			order.add(edges[edgeId], 1 + u_max);
+			int row = addKRange( order, -MILPBackend::INF, 0, 0, 1 );
+			addKCoefficient(row, edges[edgeId], 1, 1);
+		}
 
 		if (start == 0) {
 			// help u assignment: we know that if a an edge leaving 0 is chosen, the u-value has to be 1 for the node entered by the edge
 
 			// NOTE: this should be used for big instances (e.g. g06), but leads to worse runtimes for smaller instances
 
-			model.add( u[end] <= edges[edgeId] + ( (1 - edges[edgeId]) * u_max  ) );
-
+			// u_end <= edge + (1-edge) * M, i.e. u_end + (M-1) edge <= M
+			MILPBackend::Expr first;
+			first.add(u[end], 1);
+			first.add(edges[edgeId], u_max - 1);
+			int row = addKRange( first, -MILPBackend::INF, 0, 0, 1 );
+			addKCoefficient(row, edges[edgeId], -1, 1);
 		}
 
 
 	}
 
 	#ifdef STRENGTHEN_CONSTRAINTS
-	IloExpr uSum(env);
+	MILPBackend::Expr uSum;
 	#endif
 
 
@@ -610,46 +1569,171 @@ void kMST_ILP::modelMTZ()
 	// this prevents any outgoing edges
 	// the condition is not stated for node 0 to allow a start
 	for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
-		IloExpr incomingEdgesSum(env);
+		Instance::Span incomingEdgeIds = instance.incomingArcs(vertex);
+		#ifndef STRENGTHEN_CONSTRAINTS
 
+		// if there are no incoming edges, the subtrahend is 0, so u_vertex is forced to be maximal
+		// if there are incoming edges, the lhs is smaller or equal to 0, so the condition doesn't go into effect
+		// u_vertex + incomingEdgesSum * u_max >= u_max
 		{
-			vector<u_int> incomingEdgeIds;
-			getIncomingEdgeIds(incomingEdgeIds, vertex);
-
+			MILPBackend::Expr maximal;
+			maximal.add(u[vertex], 1);
 			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
-				incomingEdgesSum += edges[ incomingEdgeIds[i] ];
+				maximal.add(edges[ incomingEdgeIds[i] ], u_max);
+			}
+			int row = addKRange( maximal, 0, 1, MILPBackend::INF, 0 );
+			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+				addKCoefficient(row, edges[ incomingEdgeIds[i] ], 0, 1);
 			}
 		}
-		#ifndef STRENGTHEN_CONSTRAINTS
-
-		// if there are no incoming edges, the subtrahend is 0, so u_vertex is forced to be maximal
-		// if there are incoming edges, the lhs is smaller or equal to 0, so the condition doesn't go into effect
-		model.add( (u_max - (incomingEdgesSum * u_max)) <= u[vertex]);
-
-		// this is the same but probably more efficient, maybe test with it:
-		//model.add( IloIfThen(env, incomingEdgesSum == 0, u[vertex] == u_max) );
 		#endif
 
 
 		#ifdef STRENGTHEN_CONSTRAINTS
 		if (ACTIVATE_U_SUM) {
-			uSum += u[vertex];
-  			//alternativly all unused u to 0;
-			model.add( ((incomingEdgesSum * u_max)) >= u[vertex]);
+			uSum.add(u[vertex], 1);
+			//alternativly all unused u to 0;
+			// incomingEdgesSum * u_max - u_vertex >= 0
+			MILPBackend::Expr unused;
+			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+				unused.add(edges[ incomingEdgeIds[i] ], u_max);
+			}
+			unused.add(u[vertex], -1);
+			int row = addKRange( unused, 0, 0, MILPBackend::INF, 0 );
+			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+				addKCoefficient(row, edges[ incomingEdgeIds[i] ], 0, 1);
+			}
 		}
 		#endif
-
-		incomingEdgesSum.end();
 	}
 
 	#ifdef STRENGTHEN_CONSTRAINTS
 	//strengthening conntraint to better describe distribution of u values
 	// we wanted alldifferent(exponentially many constraints), but this has to suffice
 	if (ACTIVATE_U_SUM) {
-		int sumOverU = (k * (k+1)) / 2; 
-		model.add( uSum <= sumOverU);
+		int sumOverU = (k * (k+1)) / 2;
+		uSumLimit = backend->addRow(uSum, -MILPBackend::INF, sumOverU); // updated by setK
+	}
+	#endif
+}
+
+void kMST_ILP::modelDCC()
+{
+	// directed cut model, the exponentially many cut constraints are separated in callbacks
+
+	{
+		Instance::Span outgoingEdgeIds = instance.outgoingArcs(0);
+		if (outgoingEdgeIds.empty()) {
+			cerr << "dcc model needs the artificial root node 0\n";
+			exit( -1 );
+		}
+	}
+
+	// artificial root is always there
+	vertices.resize(instance.n_nodes);
+	for (unsigned int i=0; i<vertices.size(); i++) {
+		vertices[i] = addColumn(i == 0 ? 1 : 0, 1, 0, MILPBackend::BINARY, names ? Tools::indicesToString("y", i) : "");
+	}
+
+	MILPBackend::Expr vertexSum;
+
+	for (unsigned int vertex=1; vertex<instance.n_nodes; vertex++) {
+		vertexSum.add(vertices[vertex], 1);
+
+		// vertex is in the tree iff it is entered
+		{
+			Instance::Span incomingEdgeIds = instance.incomingArcs(vertex);
+
+			MILPBackend::Expr entered;
+			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
+				entered.add(edges[ incomingEdgeIds[i] ], 1);
+			}
+			entered.add(vertices[vertex], -1);
+			backend->addRow(entered, 0, 0);
+		}
+
+		// only vertices of the tree may be left
+		{
+			Instance::Span outgoingEdgeIds = instance.outgoingArcs(vertex);
+
+			for (unsigned int i=0; i<outgoingEdgeIds.size(); i++) {
+				MILPBackend::Expr left;
+				left.add(edges[ outgoingEdgeIds[i] ], 1);
+				left.add(vertices[vertex], -1);
+				backend->addRow(left, -MILPBackend::INF, 0);
+			}
+		}
+	}
+
+	addKRange(vertexSum, 0, 1, 0, 1);
+}
+
+void kMST_ILP::modelGSEC()
+{
+	// generalized subtour elimination model on undirected edges, subtours are separated in callbacks
+
+	// one variable per edge, the artificial root (if any) becomes an ordinary tree vertex
+	edges.resize(instance.n_edges);
+	for (unsigned int i=0; i<instance.n_edges; i++) {
+		const Instance::Edge & edgeInst = instance.edges[i];
+		edges[i] = addColumn(0, 1, edgeInst.weight, MILPBackend::BINARY,
+				names ? Tools::indicesToString("edge " , edgeInst.v1, edgeInst.v2, edgeInst.weight) : "");
+	}
+
+	bool hasRoot = !instance.incidentEdges(0).empty(); // only false for special input files
+
+	vertices.resize(instance.n_nodes);
+	for (unsigned int i=0; i<vertices.size(); i++) {
+		vertices[i] = addColumn((i == 0 && hasRoot) ? 1 : 0, 1, 0, MILPBackend::BINARY,
+				names ? Tools::indicesToString("y", i) : "");
+	}
+
+	// k real vertices (plus root), so k-1 real edges (plus one to the root)
+	{
+		MILPBackend::Expr vertexSum;
+		for (unsigned int vertex = hasRoot ? 1 : 0; vertex<instance.n_nodes; vertex++) {
+			vertexSum.add(vertices[vertex], 1);
+		}
+		addKRange(vertexSum, 0, 1, 0, 1);
+
+		MILPBackend::Expr edgeSum;
+		for (unsigned int i=0; i<edges.size(); i++) {
+			edgeSum.add(edges[i], 1);
+		}
+		addKRange(edgeSum, hasRoot ? 0 : -1, 1, hasRoot ? 0 : -1, 1);
+	}
+
+	if (hasRoot) {
+		// root is a leaf
+		MILPBackend::Expr rootEdgesSum;
+		for (const u_int* iter = instance.incidentEdges(0).begin();
+				 iter != instance.incidentEdges(0).end(); ++iter) {
+			rootEdgesSum.add(edges[*iter], 1);
+		}
+		backend->addRow(rootEdgesSum, 1, 1);
+	}
+
+	// edges only between selected vertices
+	for (unsigned int i=0; i<instance.n_edges; i++) {
+		MILPBackend::Expr first, second;
+		first.add(edges[i], 1);
+		first.add(vertices[ instance.edges[i].v1 ], -1);
+		backend->addRow(first, -MILPBackend::INF, 0);
+		second.add(edges[i], 1);
+		second.add(vertices[ instance.edges[i].v2 ], -1);
+		backend->addRow(second, -MILPBackend::INF, 0);
+	}
+
+	// selected vertices are not isolated
+	for (unsigned int vertex=0; vertex<instance.n_nodes; vertex++) {
+		MILPBackend::Expr degree;
+		for (const u_int* iter = instance.incidentEdges(vertex).begin();
+				 iter != instance.incidentEdges(vertex).end(); ++iter) {
+			degree.add(edges[*iter], 1);
+		}
+		degree.add(vertices[vertex], -1);
+		backend->addRow(degree, 0, MILPBackend::INF);
 	}
-	#endif 
 }
 
 /* original version, results in excellent values for 07/60, but is worse for all others
@@ -692,8 +1776,7 @@ void kMST_ILP::modelMTZ()
 		IloExpr incomingEdgesSum(env);
 
 		{
-			vector<u_int> incomingEdgeIds;
-			getIncomingEdgeIds(incomingEdgeIds, vertex);
+			Instance::Span incomingEdgeIds = instance.incomingArcs(vertex);
 
 			for (unsigned int i=0; i<incomingEdgeIds.size(); i++) {
 				incomingEdgesSum += edges[ incomingEdgeIds[i] ];
@@ -717,8 +1800,9 @@ void kMST_ILP::modelMTZ()
 
 kMST_ILP::~kMST_ILP()
 {
-	// free global CPLEX resources
-	cplex.end();
-	model.end();
-	env.end();
+	// free the solver
+	delete backend;
+	pthread_mutex_destroy(&fixingMutex);
+	pthread_mutex_destroy(&repairMutex);
+	pthread_mutex_destroy(&abortMutex);
 }
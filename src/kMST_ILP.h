@@ -3,19 +3,44 @@
 
 #include "Tools.h"
 #include "Instance.h"
-#include <ilcplex/ilocplex.h>
+#include "CutSeparator.h"
+#include "Heuristic.h"
+#include "ProgressLog.h"
+#include "SharedIncumbent.h"
+#include "MILPBackend.h"
 
 #include <iostream>
+#include <pthread.h>
 
 #define STRENGTHEN_CONSTRAINTS
 
 using namespace std;
 
-ILOSTLBEGIN
-
-class kMST_ILP
+// the models built against a MILPBackend (CPLEX by default), the callbacks of the models are
+// the hooks of MILPBackend::Callback
+class kMST_ILP : public MILPBackend::Callback
 {
 
+public:
+
+	// wall clock seconds of the phases of the last solve, build and extraction only on the first one
+	struct Timings
+	{
+		double build, extraction, rootLP, branchAndBound;
+	};
+
+	// flow columns of mcf, the flows of a commodity are at firstFlow + slot * keptArcs + position
+	struct MCFLayout
+	{
+		vector<int> arcPosition; // per arc, -1 without flow
+		vector<u_int> arcs; // arcs with flow by position
+		vector<int> commoditySlot; // per vertex, -1 without commodity
+		vector<bool> vertexKept; // vertex which may be part of the tree
+		int keptArcs;
+		int firstFlow;
+		bool coupling; // flow <= edge rows are part of the model, otherwise separated
+	};
+
 private:
 
 	// input data
@@ -25,44 +50,201 @@ private:
 	// number of edges and nodes including root node and root edges
 	u_int m, n;
 
-	IloEnv env;
-	IloModel model;
-	IloCplex cplex;
-
-	IloBoolVarArray edges; // first half one direction, second half other direction
-
-	IloNumVarArray flow_scf; // only used for scf (admittedly somewhat ugly, but this is no coding course :)
-	vector<IloBoolVarArray> flow_mcf; // used for mcf (same Hack here)
-	IloIntVarArray u; // only used for mtz
+	string backendName;
+	MILPBackend* backend;
+	int columns; // added to the backend so far
+
+	// column indices of the variables
+	vector<int> edges; // first half one direction, second half other direction (gsec: undirected, one per edge)
+
+	vector<int> flow_scf; // only used for scf (admittedly somewhat ugly, but this is no coding course :)
+	vector<vector<int> > flow_mcf; // used for mcf (same Hack here), per commodity the arcs with flow
+	vector<int> u; // only used for mtz
+	int uMin; // lower bound of u of the real vertices
+	vector<int> vertices; // only used for dcc, gsec, root symmetry breaking and vertex branching, 1 iff vertex is part of the tree
+	vector<int> rootPrefix; // root symmetry breaking only, 1 iff the root is at most the vertex
+
+	CutSeparator separator; // connectivity cuts for dcc and gsec
+
+	vector<bool> excludedEdges; // empty if nothing is excluded
+
+	bool rootSymmetry; // scf-root, mtz-root: the tree is entered from 0 at its smallest vertex
+	bool names; // variable names, only of use for exported models and costly for mcf
+	bool mcfLean; // mcf-lean: commodities of possible vertices, continuous flows, coupling rows separated
+	bool nodeFixing; // fixes variables by Lagrangian reduced costs against the incumbent in the tree
+	bool vertexBranching; // branches on fractional vertex variables before the arcs
+	int repairFrequency; // LP points repaired to k-trees every x nodes, 0: never
+	double repairBudget; // seconds of repair per solve, 0: no limit
+
+	u_int threads; // budget of the job, 0: single threaded solver and heuristic on all cores
+	int parallelMode; // MILPBackend::ParallelMode
+	double workMemory, treeMemory; // limits in MB, 0: solver defaults
+	double timeLimit; // seconds per solve, <= 0: none
+
+	bool built; // model is built once and only updated by setK afterwards
+	bool optimal; // last solve proved optimality
+	KTree warmStart; // additional MIP start for the next solve
+	KTree solution;
+
+	// parts of the model which depend on k, values are constant + perK * k
+	struct KRange { int row; double lbConstant, lbPerK, ubConstant, ubPerK; };
+	struct KCoefficient { int row, column; double constant, perK; };
+	struct KUpperBound { int column; double lb, constant, perK; };
+	vector<KRange> kRanges;
+	vector<KCoefficient> kCoefficients;
+	vector<KUpperBound> kUpperBounds;
+	int uSumLimit; // mtz only, quadratic in k, -1 if not part of the model
+	MCFLayout mcfLayout;
+
+	// node fixing: per edge a lower bound on every solution containing it, and the arcs (ids < edges.size())
+	// and vertices (edges.size() + vertex) which can't improve the incumbent they were computed for
+	vector<double> fixingBounds;
+	double fixingIncumbent;
+	vector<u_int> fixingCandidates;
+	vector<bool> fixingSeen; // candidates fixed at some node against fixingIncumbent
+	pthread_mutex_t fixingMutex; // branch callbacks may run on several threads
+
+	// lp repair of the current solve
+	int repairNextNode;
+	int repairRuns;
+	double repairTime;
+	pthread_mutex_t repairMutex;
 
 	int nodes; //branch an bound nodes
 	double objectiveValue; // cost
 
+	Timings timings;
+	double rootEnd; // wall time when the root node was done, set by a callback
+	ProgressLog progressLog; // incumbent and bound of the last solve
+
+	volatile bool aborted; // abort before the backend exists
+	pthread_mutex_t abortMutex;
+	SharedIncumbent* shared; // NULL unless solved concurrently with other models
+	u_int sharedVersion; // of the last tree taken from shared
+
 	void modelSCF();
 	void modelMCF();
+	void layoutMCF();
 	void modelMTZ();
+	void modelDCC();
+	void modelGSEC();
 
 
 public:
 
 	kMST_ILP( Instance& _instance, string _model_type, int _k );
 	~kMST_ILP();
-	void solve();
+	void solve(); // builds the model on the first call, later calls reuse it
 	int getNodes();
 	double getObjectiveValue();
 	double getcpuTime();
+	const KTree& getTree(); // of the last solve
+	bool isOptimal(); // false if the last solve was aborted or hit a limit
+	const Timings& getTimings();
+	const ProgressLog& getProgress();
+
+	// cplex or highs, default MILPBackend::defaultName(), before the first solve
+	void setBackend( string name );
+	// false if the model needs callbacks the backend doesn't have (dcc, gsec, mcf-lean on highs)
+	static bool isSupported( string model_type, string backend );
+
+	// progress samples at most every x seconds besides improvements, objective value for the time to target
+	void setProgressInterval( double seconds );
+	void setProgressTarget( double target );
+
+	// changes k of a built model in place (cardinality, flow and mtz bounds), exclusions are kept
+	void setK( int _k );
+
+	// tree, e.g. a solution for another k, to try as additional start of the next solve
+	void setWarmStart( const KTree& tree );
+
+	// must be called after the model has been built (done in solve)
+	void addMIPStart( const KTree& tree );
+
+	// edges (ids in instance.edges) whose variables are fixed to 0, e.g. by reduced cost arguments
+	void setExcludedEdges( const vector<bool>& _excludedEdges );
+
+	// threads for the solver and the start heuristic, e.g. when several jobs share the machine
+	void setThreads( u_int _threads );
+
+	// -1 opportunistic, 0 the solver decides, 1 deterministic (default, reproducible node counts)
+	void setParallelMode( int mode );
+	static int parseParallelMode( string name ); // opportunistic, auto or deterministic
+
+	// working memory and branch-and-bound tree size in MB, the solve stops at the tree limit
+	void setMemoryLimits( double _workMemory, double _treeMemory );
+
+	// wall clock seconds per solve, the result is not proven optimal if it is hit
+	void setTimeLimit( double seconds );
+
+	// names of the variables as in "f(2,5)", off by default
+	void setVariableNames( bool _names );
+
+	// fixes arcs, their flows and vertices which can't improve the incumbent at the nodes of the tree,
+	// turns off dynamic search of CPLEX (branch callback)
+	void setNodeFixing( bool _nodeFixing );
+
+	// branches on the most fractional y_v (vertex v is part of the tree) while there is one, the arcs
+	// are left to the solver; the compact models get y_v = sum of the arcs into v for this
+	void setVertexBranching( bool _vertexBranching );
+
+	// heuristic callback: the LP point of every frequency-th node (and the root) is repaired to a k-tree
+	// which becomes the incumbent if it is better, at most budget seconds per solve (0: no limit)
+	void setLPRepair( int frequency, double budget );
+
+	// exchange incumbents with other models solving the same instance and k
+	void setSharedIncumbent( SharedIncumbent* _shared );
+
+	// stops a running or the next solve, may be called from another thread
+	void abort();
+
+	// hooks of MILPBackend::Callback
+	void separateLazy( const vector<double>& values, vector<MILPBackend::Row>& rows );
+	void separateCuts( const vector<double>& values, vector<MILPBackend::Row>& rows );
+	bool findSolution( const MILPBackend::Node& node, MILPBackend::Expr& start, double& objective );
+	void branch( MILPBackend::BranchNode& node );
+	void progress( const MILPBackend::Progress& state );
+	void incumbent( const vector<double>& values, double objective );
+
+	// used by the mcf workers, rows of one commodity starting at the given row and entry
+	void fillMCFRows( u_int commodity, MILPBackend::RowBlock& rows, int row, int entry ) const;
 
 private:
 
-	void setCPLEXParameters();
+	void setParameters();
+	bool hasVertexVariables() const;
+	int getHooks() const; // of the models and options
 
-	void addTreeConstraints();
-	void addObjectiveFunction();
+	void buildModel();
+
+	// values of all columns
+	KTree valuesToTree( const vector<double>& values ) const;
+	void treeToValues( const KTree& tree, MILPBackend::Expr& values );
 
-	void getOutgoingEdgeIds(vector<u_int> & outgoingEdges, u_int vertex);
-	void getIncomingEdgeIds(vector<u_int> & incomingEdgeIds, u_int vertex);
-	void getVertexEdgeIds(vector<u_int> & incomingEdgeIds, u_int vertex, bool outgoing); // internal
+	int addColumn( double lb, double ub, double cost, MILPBackend::VarType type, const string& name );
+	int addKRange( const MILPBackend::Expr& expr, double lbConstant, double lbPerK,
+			double ubConstant, double ubPerK );
+	void addKCoefficient( int row, int column, double constant, double perK );
+	void addKUpperBound( int column, double lb, double constant, double perK );
+
+	// connectivity cuts of dcc and gsec, coupling rows of mcf-lean
+	void separate( const vector<double>& values, vector<MILPBackend::Row>& rows, double minViolation );
+
+	void getFixingCandidates( double incumbent, vector<u_int>& candidates );
+	int getFixingColumn( u_int candidate ) const;
+	void addFixingCompanions( u_int candidate, vector<int>& columns ) const; // flows of an arc
+	void recordFixing( double incumbent, const vector<u_int>& fixed ); // candidates fixed at a node
+	bool isRepairDue( int nodes );
+	bool pollSharedIncumbent( KTree& tree ); // tree of another model newer than the last one taken
+	KTree repairTree( const vector<double>& edgeValues );
+
+	void addTreeConstraints();
+	void addVertexVariables();
+	void addRootSymmetryBreaking();
+	void applyExclusions();
 
+	kMST_ILP( const kMST_ILP& );
+	kMST_ILP& operator=( const kMST_ILP& );
 
 };
 // kMST_ILP
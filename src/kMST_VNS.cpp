@@ -0,0 +1,536 @@
+#include "kMST_VNS.h"
+
+#include <pthread.h>
+#include <cstdlib>
+#include <climits>
+#include <algorithm>
+
+// ----- tree with incremental mst maintenance ---------------------------
+
+// k-tree which always is a minimum spanning tree of the subgraph induced by its vertices
+// inserting a vertex adds its edges one by one and drops the heaviest edge of each closed cycle,
+// removing a leaf keeps the property as well
+class IncrementalTree
+{
+
+public:
+
+	// operations of one insertion or leaf removal, so it can be taken back
+	struct Change
+	{
+		u_int vertex;
+		bool inserted; // false for a removed leaf
+		int weight; // before the change
+		vector<pair<u_int, bool> > operations; // edge id, true if added
+	};
+
+	int weight;
+	vector<u_int> vertices;
+
+	IncrementalTree( const Instance& _instance ) :
+			weight( 0 ), instance( &_instance ), inTree( _instance.n_nodes, false ),
+			adjacent( _instance.n_nodes ), position( _instance.n_nodes, -1 ),
+			stamp( _instance.n_nodes, 0 ), currentStamp( 0 ), parentEdge( _instance.n_nodes, 0 )
+	{
+	}
+
+	void assign( const KTree& tree )
+	{
+		history.clear();
+		while (!vertices.empty()) {
+			u_int vertex = vertices.back();
+			vertices.pop_back();
+			inTree[vertex] = false;
+			position[vertex] = -1;
+			adjacent[vertex].clear();
+		}
+		for (unsigned int i=0; i<tree.vertices.size(); i++) {
+			addVertex(tree.vertices[i]);
+		}
+		for (unsigned int i=0; i<tree.edges.size(); i++) {
+			addEdge(tree.edges[i]);
+		}
+		weight = tree.weight;
+	}
+
+	KTree toKTree() const
+	{
+		KTree tree;
+		tree.vertices = vertices;
+		for (unsigned int i=0; i<vertices.size(); i++) {
+			for (unsigned int j=0; j<adjacent[ vertices[i] ].size(); j++) {
+				u_int edgeId = adjacent[ vertices[i] ][j];
+				if (otherEnd(edgeId, vertices[i]) > vertices[i]) {
+					tree.edges.push_back(edgeId);
+				}
+			}
+		}
+		tree.weight = weight;
+		return tree;
+	}
+
+	bool contains( u_int vertex ) const
+	{
+		return inTree[vertex];
+	}
+
+	bool isLeaf( u_int vertex ) const
+	{
+		return inTree[vertex] && adjacent[vertex].size() == 1;
+	}
+
+	int leafWeight( u_int leaf ) const
+	{
+		return instance->edges[ adjacent[leaf][0] ].weight;
+	}
+
+	// leaf with the most expensive edge other than except
+	u_int heaviestLeaf( u_int except ) const
+	{
+		u_int leaf = vertices[0];
+		int leafEdgeWeight = -1;
+		for (unsigned int i=0; i<vertices.size(); i++) {
+			if (vertices[i] != except && isLeaf(vertices[i]) && leafWeight(vertices[i]) > leafEdgeWeight) {
+				leaf = vertices[i];
+				leafEdgeWeight = leafWeight(leaf);
+			}
+		}
+		return leaf;
+	}
+
+	// kept in the history
+	void insertVertex( u_int vertex )
+	{
+		history.push_back(Change());
+		insertVertex(vertex, history.back());
+	}
+
+	// not kept in the history, taken back by undo
+	void insertVertex( u_int vertex, Change& change )
+	{
+		change.vertex = vertex;
+		change.inserted = true;
+		change.weight = weight;
+		change.operations.clear();
+
+		// edges to the tree by increasing weight
+		vector<pair<int, u_int> > connecting;
+		for (const u_int* iter = instance->incidentEdges(vertex).begin();
+				 iter != instance->incidentEdges(vertex).end(); ++iter) {
+			u_int other = otherEnd(*iter, vertex);
+			if (inTree[other] && other != 0) {
+				connecting.push_back(pair<int, u_int>(instance->edges[*iter].weight, *iter));
+			}
+		}
+		sort(connecting.begin(), connecting.end());
+
+		addVertex(vertex);
+		for (unsigned int i=0; i<connecting.size(); i++) {
+			u_int edgeId = connecting[i].second;
+			if (i == 0) {
+				addEdge(edgeId);
+				change.operations.push_back(pair<u_int, bool>(edgeId, true));
+				weight += connecting[i].first;
+				continue;
+			}
+
+			// cycle closed by edge, drop its heaviest edge if it is more expensive
+			u_int heaviest = heaviestOnPath(vertex, otherEnd(edgeId, vertex));
+			if (instance->edges[heaviest].weight > connecting[i].first) {
+				removeEdge(heaviest);
+				change.operations.push_back(pair<u_int, bool>(heaviest, false));
+				addEdge(edgeId);
+				change.operations.push_back(pair<u_int, bool>(edgeId, true));
+				weight += connecting[i].first - instance->edges[heaviest].weight;
+			}
+		}
+	}
+
+	void undo( const Change& change )
+	{
+		if (!change.inserted) {
+			addVertex(change.vertex);
+		}
+		for (int i=change.operations.size()-1; i>=0; i--) {
+			if (change.operations[i].second) {
+				removeEdge(change.operations[i].first);
+			} else {
+				addEdge(change.operations[i].first);
+			}
+		}
+		if (change.inserted) {
+			removeVertex(change.vertex);
+		}
+		weight = change.weight;
+	}
+
+	// kept in the history
+	void removeLeaf( u_int leaf )
+	{
+		Change change;
+		change.vertex = leaf;
+		change.inserted = false;
+		change.weight = weight;
+		change.operations.push_back(pair<u_int, bool>(adjacent[leaf][0], false));
+		history.push_back(change);
+
+		weight -= leafWeight(leaf);
+		removeEdge(adjacent[leaf][0]);
+		removeVertex(leaf);
+	}
+
+	// keeps the changes of the history or takes them back, in place of a copy of the tree
+	void commit()
+	{
+		history.clear();
+	}
+
+	void rollback()
+	{
+		while (!history.empty()) {
+			undo(history.back());
+			history.pop_back();
+		}
+	}
+
+	// vertices outside which have an edge into the tree
+	void getCandidates( vector<u_int>& candidates )
+	{
+		candidates.clear();
+		currentStamp++;
+		for (unsigned int i=0; i<vertices.size(); i++) {
+			for (const u_int* iter = instance->incidentEdges( vertices[i] ).begin();
+					 iter != instance->incidentEdges( vertices[i] ).end(); ++iter) {
+				u_int other = otherEnd(*iter, vertices[i]);
+				if (!inTree[other] && other != 0 && stamp[other] != currentStamp) {
+					stamp[other] = currentStamp;
+					candidates.push_back(other);
+				}
+			}
+		}
+	}
+
+private:
+
+	const Instance* instance;
+	vector<bool> inTree;
+	vector<vector<u_int> > adjacent; // tree edge ids per vertex
+	vector<int> position; // index in vertices
+	vector<Change> history; // since the last commit
+
+	// search buffers
+	vector<u_int> stamp;
+	u_int currentStamp;
+	vector<u_int> parentEdge;
+
+	u_int otherEnd( u_int edgeId, u_int vertex ) const
+	{
+		const Instance::Edge & edge = instance->edges[edgeId];
+		return (edge.v1 == vertex) ? edge.v2 : edge.v1;
+	}
+
+	void addVertex( u_int vertex )
+	{
+		inTree[vertex] = true;
+		position[vertex] = vertices.size();
+		vertices.push_back(vertex);
+	}
+
+	void removeVertex( u_int vertex )
+	{
+		u_int last = vertices.back();
+		vertices[ position[vertex] ] = last;
+		position[last] = position[vertex];
+		vertices.pop_back();
+		position[vertex] = -1;
+		inTree[vertex] = false;
+	}
+
+	void addEdge( u_int edgeId )
+	{
+		adjacent[ instance->edges[edgeId].v1 ].push_back(edgeId);
+		adjacent[ instance->edges[edgeId].v2 ].push_back(edgeId);
+	}
+
+	void removeEdge( u_int edgeId )
+	{
+		vector<u_int> & first = adjacent[ instance->edges[edgeId].v1 ];
+		first.erase(find(first.begin(), first.end(), edgeId));
+		vector<u_int> & second = adjacent[ instance->edges[edgeId].v2 ];
+		second.erase(find(second.begin(), second.end(), edgeId));
+	}
+
+	// heaviest edge on the tree path between from and to (bfs)
+	u_int heaviestOnPath( u_int from, u_int to )
+	{
+		currentStamp++;
+		vector<u_int> queue;
+		queue.push_back(from);
+		stamp[from] = currentStamp;
+		for (unsigned int i=0; i<queue.size() && stamp[to] != currentStamp; i++) {
+			u_int vertex = queue[i];
+			for (unsigned int j=0; j<adjacent[vertex].size(); j++) {
+				u_int other = otherEnd(adjacent[vertex][j], vertex);
+				if (stamp[other] != currentStamp) {
+					stamp[other] = currentStamp;
+					parentEdge[other] = adjacent[vertex][j];
+					queue.push_back(other);
+				}
+			}
+		}
+
+		u_int heaviest = parentEdge[to];
+		for (u_int vertex=to; vertex!=from; vertex=otherEnd(parentEdge[vertex], vertex)) {
+			if (instance->edges[ parentEdge[vertex] ].weight > instance->edges[heaviest].weight) {
+				heaviest = parentEdge[vertex];
+			}
+		}
+		return heaviest;
+	}
+
+};
+
+// ----- search ----------------------------------------------------------
+
+struct VNSShared
+{
+	pthread_mutex_t mutex;
+	KTree best;
+	long iterations;
+};
+
+struct VNSWorker
+{
+	const Instance* instance;
+	int k;
+	double deadline;
+	int restartIterations;
+	unsigned int seed;
+	KTree start;
+	VNSShared* shared;
+};
+
+// best add-drop move: insert an outside vertex, then drop the heaviest of the other leaves
+static bool addDropStep( IncrementalTree& tree, vector<u_int>& candidates )
+{
+	tree.getCandidates(candidates);
+
+	int bestGain = 0;
+	u_int bestIn = 0, bestOut = 0;
+	IncrementalTree::Change change;
+	for (unsigned int i=0; i<candidates.size(); i++) {
+		int before = tree.weight;
+		tree.insertVertex(candidates[i], change);
+		u_int leaf = tree.heaviestLeaf(candidates[i]);
+		int gain = before - (tree.weight - tree.leafWeight(leaf));
+		if (gain > bestGain) {
+			bestGain = gain;
+			bestIn = candidates[i];
+			bestOut = leaf;
+		}
+		tree.undo(change);
+	}
+
+	if (bestGain <= 0) {
+		return false;
+	}
+	tree.insertVertex(bestIn);
+	tree.removeLeaf(bestOut);
+	return true;
+}
+
+// drop strength random leaves and grow back by random outside vertices
+static void shake( IncrementalTree& tree, int strength, unsigned int& seed, vector<u_int>& buffer )
+{
+	for (int i=0; i<strength && tree.vertices.size() > 1; i++) {
+		buffer.clear();
+		for (unsigned int j=0; j<tree.vertices.size(); j++) {
+			if (tree.isLeaf(tree.vertices[j])) {
+				buffer.push_back(tree.vertices[j]);
+			}
+		}
+		tree.removeLeaf(buffer[ rand_r(&seed) % buffer.size() ]);
+	}
+
+	for (int i=0; i<strength; i++) {
+		tree.getCandidates(buffer);
+		if (buffer.empty()) {
+			break;
+		}
+		tree.insertVertex(buffer[ rand_r(&seed) % buffer.size() ]);
+	}
+}
+
+static void* runVNSWorker( void* arg )
+{
+	VNSWorker* worker = (VNSWorker*)arg;
+	VNSShared* shared = worker->shared;
+	const int SHARE_INTERVAL = 20;
+	const int maxStrength = max(1, min(worker->k / 2, 10));
+
+	IncrementalTree current(*worker->instance);
+	current.assign(worker->start);
+	KTreeHeuristic heuristic(*worker->instance, worker->k);
+	vector<u_int> buffer;
+
+	int strength = 1;
+	int idle = 0; // iterations without improving current
+	int seen = current.weight; // shared best when this thread last looked
+	long iterations = 0, restarts = 0;
+	while (Tools::wallTime() < worker->deadline) {
+		// the trial changes current in place and is taken back unless it improves
+		int before = current.weight;
+		shake(current, strength, worker->seed, buffer);
+		while (addDropStep(current, buffer));
+
+		// trees may have lost vertices when the graph has no more candidates
+		if ((int)current.vertices.size() == worker->k && current.weight < before) {
+			current.commit();
+			strength = 1;
+			idle = 0;
+		} else {
+			current.rollback();
+			strength = strength % maxStrength + 1;
+		}
+		iterations++;
+		idle++;
+
+		if (iterations % SHARE_INTERVAL == 0) {
+			// improvements of other threads are taken over, but not the best a restart left
+			pthread_mutex_lock(&shared->mutex);
+			if (current.weight < shared->best.weight) {
+				shared->best = current.toKTree();
+			} else if (shared->best.weight < seen) {
+				current.assign(shared->best);
+				idle = 0;
+			}
+			seen = shared->best.weight;
+			pthread_mutex_unlock(&shared->mutex);
+		}
+
+		// local optimum: continue from the best tree, perturbed beyond the reach of the shakes,
+		// or from a tree grown at a random vertex for another part of the graph
+		if (idle >= worker->restartIterations) {
+			KTree grown;
+			if (restarts++ % 2 == 1) {
+				grown = heuristic.grow(1 + rand_r(&worker->seed) % (worker->instance->n_nodes - 1));
+			}
+			if (grown.isValid()) {
+				current.assign(heuristic.spanningTree(grown.vertices));
+			} else {
+				pthread_mutex_lock(&shared->mutex);
+				current.assign(shared->best);
+				pthread_mutex_unlock(&shared->mutex);
+				shake(current, max(maxStrength, (int)(worker->k / 4 + rand_r(&worker->seed) % (worker->k / 2 + 1))),
+						worker->seed, buffer);
+			}
+			while (addDropStep(current, buffer));
+			if ((int)current.vertices.size() == worker->k) {
+				current.commit();
+			} else {
+				current.rollback();
+			}
+			strength = 1;
+			idle = 0;
+		}
+	}
+
+	pthread_mutex_lock(&shared->mutex);
+	if (current.weight < shared->best.weight) {
+		shared->best = current.toKTree();
+	}
+	shared->iterations += iterations;
+	pthread_mutex_unlock(&shared->mutex);
+	return NULL;
+}
+
+// ----- public methods --------------------------------------------------
+
+kMST_VNS::kMST_VNS( const Instance& _instance, int _k ) :
+		instance( _instance ), k( _k ), threads( Tools::availableCores() ),
+		timeLimit( 10 ), restartIterations( 0 ), iterations( 0 )
+{
+	if( k == 0 ) k = instance.n_nodes - 1;
+}
+
+void kMST_VNS::setThreads( u_int _threads )
+{
+	threads = max(_threads, 1u);
+}
+
+void kMST_VNS::setTimeLimit( double seconds )
+{
+	timeLimit = seconds;
+}
+
+void kMST_VNS::setRestartIterations( int _restartIterations )
+{
+	restartIterations = _restartIterations;
+}
+
+void kMST_VNS::solve()
+{
+	double deadline = Tools::wallTime() + timeLimit;
+
+	// construction heuristic gives the common start
+	KTreeHeuristic heuristic(instance, k);
+	KTree start = heuristic.solve(threads);
+	if (start.isValid()) {
+		start = heuristic.spanningTree(start.vertices);
+	}
+	cout << "Heuristic solution: " << start.weight << "\n";
+
+	best = start;
+	iterations = 0;
+	if (!start.isValid() || start.edges.empty()) {
+		return;
+	}
+
+	VNSShared shared;
+	pthread_mutex_init(&shared.mutex, NULL);
+	shared.best = start;
+	shared.iterations = 0;
+
+	vector<VNSWorker> workers(threads);
+	vector<pthread_t> handles(threads);
+	for (u_int i=0; i<threads; i++) {
+		workers[i].instance = &instance;
+		workers[i].k = k;
+		workers[i].deadline = deadline;
+		workers[i].restartIterations = restartIterations > 0 ? restartIterations : 50 + k / 2 + instance.n_nodes / 20;
+		workers[i].seed = 7919 * i + 1;
+		workers[i].start = start;
+		workers[i].shared = &shared;
+	}
+
+	// worker 0 runs in the calling thread
+	for (u_int i=1; i<threads; i++) {
+		pthread_create(&handles[i], NULL, runVNSWorker, &workers[i]);
+	}
+	runVNSWorker(&workers[0]);
+	for (u_int i=1; i<threads; i++) {
+		pthread_join(handles[i], NULL);
+	}
+	pthread_mutex_destroy(&shared.mutex);
+
+	best = shared.best;
+	iterations = shared.iterations;
+
+	cout << "VNS iterations: " << iterations << "\n";
+	cout << "Objective value: " << best.weight << "\n";
+}
+
+double kMST_VNS::getObjectiveValue()
+{
+	return best.weight;
+}
+
+long kMST_VNS::getIterations()
+{
+	return iterations;
+}
+
+const KTree& kMST_VNS::getTree()
+{
+	return best;
+}
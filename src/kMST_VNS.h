@@ -0,0 +1,45 @@
+#ifndef __K_MST_VNS__H__
+#define __K_MST_VNS__H__
+
+#include "Tools.h"
+#include "Instance.h"
+#include "Heuristic.h"
+
+using namespace std;
+
+// variable neighbourhood search over k-trees, needs no CPLEX
+// every thread runs its own search and periodically exchanges the best tree, a thread stuck in a local
+// optimum restarts from a perturbed copy of the best tree, the search ends with the time limit
+class kMST_VNS
+{
+
+private:
+
+	const Instance& instance;
+	int k;
+
+	u_int threads;
+	double timeLimit; // wall clock seconds
+	int restartIterations; // per thread, without improvement before a restart, 0: 50 + k/2 + n/20
+
+	KTree best;
+	long iterations;
+
+public:
+
+	kMST_VNS( const Instance& _instance, int _k );
+
+	void setThreads( u_int _threads );
+	void setTimeLimit( double seconds );
+	void setRestartIterations( int _restartIterations );
+
+	void solve();
+
+	double getObjectiveValue();
+	long getIterations();
+	const KTree& getTree();
+
+};
+// kMST_VNS
+
+#endif //__K_MST_VNS__H__